@@ -21,6 +21,7 @@
 
 
 #include <EBYTE_E220.h>
+#include <EBYTE_E220_Receiver.h>
 #include <Stream.h>
 
 #if ARDUINO >= 100
@@ -40,6 +41,22 @@ EBYTE_E220::EBYTE_E220(Stream *s, uint8_t PIN_M0, uint8_t PIN_M1, uint8_t PIN_AU
 	_M0 = PIN_M0;
 	_M1 = PIN_M1;
 	_AUX = PIN_AUX;		
+	_pins = NULL;
+	_receiver = NULL;
+	_sleeping = false;
+	_wakeTime = 0;
+	// unknown until the first setMode(), treat anything in the buffer as junk
+	_mode = MODE_PROGRAM;
+	_atStatus = EBYTE_AT_PENDING;
+	_op = 0;
+	_opStatus = EBYTE_OP_IDLE;
+	CRYPT_H = 0;
+	CRYPT_L = 0;
+	PRODINFO = 0;
+
+#ifdef EBYTE_E220_STATS
+	Stats.reset();
+#endif
 }
 
 /*
@@ -49,6 +66,12 @@ for potential future module programming
 
 bool EBYTE_E220::init() {
 
+	// put to sleep by us, the registers we have are still the module's. if it doesn't wake
+	// wake() has cleared _sleeping and the full init below finds out what state it's in
+	if (_sleeping && wake()) {
+		return true;
+	}
+
 	pinMode(_AUX, INPUT);
 	pinMode(_M0, OUTPUT);
 	pinMode(_M1, OUTPUT);
@@ -58,25 +81,68 @@ bool EBYTE_E220::init() {
 	// get the EBYTE Model
 
 	if (!ReadModel()){
-		Serial.println("EBYTE_E220::ReadModel() fail");
+		EBYTE_LOGE(EBYTE_ERR_READ_MODEL, _atStatus);
 		return false;
 	}
 
 	// get the EBYTE version
 	if (!ReadVersion()){
-		Serial.println("EBYTE_E220::ReadVersion() fail");
+		EBYTE_LOGE(EBYTE_ERR_READ_VERSION, _atStatus);
 		return false;
 	}
 
 	// get the EBYTE parameters
 	if (!ReadParameters()) {
-		Serial.println("EBYTE_E220::ReadParameters failed");
+		EBYTE_LOGE(EBYTE_ERR_READ_PARAMS, Params[0]);
 		return false;
 	}
 
 	return true;
 }
 
+/*
+start from a register image saved earlier with getRegisters() instead of asking the module, for
+when the MCU wakes from a sleep that lost its memory but the module kept its settings
+no AT commands and no register reads, so getModel() and getVersion() are empty
+*/
+
+bool EBYTE_E220::init(const uint8_t *image, uint8_t mode) {
+
+	pinMode(_AUX, INPUT);
+	pinMode(_M0, OUTPUT);
+	pinMode(_M1, OUTPUT);
+
+	Params[0] = EBYTE_READ;
+	memcpy(Params + 3, image, 8);
+	Params[11] = PRODINFO;
+	ParseParameters();
+
+	setMode(mode);
+
+	return true;
+}
+
+// copy the 8 register values (ADDH, ADDL, REG0 to REG3, CRYPT_H, CRYPT_L) for init(image)
+
+void EBYTE_E220::getRegisters(uint8_t *image) {
+
+	BuildParams();
+	memcpy(image, Params, 8);
+}
+
+// set every field from an 8 register image, like calling all the setters, nothing is sent
+
+void EBYTE_E220::setRegisters(const uint8_t *image) {
+
+	memcpy(Params + 3, image, 8);
+	Params[11] = PRODINFO;
+	ParseParameters();
+}
+
+uint8_t EBYTE_E220::getMode() {
+	return _mode;
+}
+
 /*
 Utility method to wait until module is doen tranmitting
 a timeout is provided to avoid an infinite loop
@@ -85,18 +151,20 @@ a timeout is provided to avoid an infinite loop
 void EBYTE_E220::CompleteTask(unsigned long timeout) {
 
 	unsigned long t = millis();
+	EBYTE_STAT_START(st);
 
 	// if AUX pin was supplied and look for HIGH state
 	// note you can omit using AUX if no pins are available, but you will have to use delay() to let module finish
 
-	if (_AUX != -1) {
+	if (_AUX != -1 || _pins) {
 		
-		while (digitalRead(_AUX) == LOW) {
-			// Serial.println("EBYTE_E220::CompleteTask");
+		while (getAux() == LOW) {
 
 			delay(2);
 			if ((millis() - t) > timeout){
-				Serial.println("FAIL EBYTE_E220::CompleteTask");
+				EBYTE_LOGE(EBYTE_ERR_TASK_TIMEOUT, millis() - t);
+				EBYTE_STAT_ADD(TaskTimeouts, 1);
+				EBYTE_TRACE(EBYTE_EVT_TASK_TIMEOUT, micros() - st);
 				break;
 			}
 		}
@@ -108,6 +176,9 @@ void EBYTE_E220::CompleteTask(unsigned long timeout) {
 
 	}
 
+	EBYTE_STAT_END(TaskWait, st);
+	EBYTE_TRACE(EBYTE_EVT_TASK_DONE, micros() - st);
+
 	// delay(PIN_RECOVER);
 }
 
@@ -117,11 +188,112 @@ method to set the mode (program, normal, etc.)
 
 void EBYTE_E220::setMode(uint8_t mode) {
 	
+	EBYTE_STAT_START(st);
+
 	// data sheet claims module needs some extra time after mode setting (2ms)
 	// most of my projects uses 10 ms, but 40ms is safer
 
 	delay(PIN_RECOVER);
+
+	// anything received so far goes to the receiver (if attached) before the module stops listening
+	ClearBuffer();
+	
+	SetPins(mode);
+
+	// data sheet says 2ms later control is returned, let's give just a bit more time
+	// these modules can take time to activate pins
+	delay(PIN_RECOVER);
+
+	// clear out any junk, this is still judged by the mode we came from
+	// so program mode responses are discarded but received data is kept
+	ClearBuffer();
+	_mode = mode;
+	_sleeping = false;
+
+	// wait until aux pin goes back low
+	CompleteTask(4000);
+
+	EBYTE_STAT_END(SetMode, st);
+	EBYTE_TRACE(EBYTE_EVT_SETMODE, mode);
 	
+}
+
+/*
+method to power the module down between samples, unlike setMode() there are no fixed delays,
+once anything we sent is off the air the pins change and that's it
+*/
+
+void EBYTE_E220::sleep() {
+
+	CompleteTask(1000);
+
+	// whatever came in is the receiver's before the module goes quiet
+	ClearBuffer();
+
+	SetPins(MODE_POWERDOWN);
+	_mode = MODE_POWERDOWN;
+	_sleeping = true;
+
+	EBYTE_TRACE(EBYTE_EVT_SETMODE, MODE_POWERDOWN);
+}
+
+/*
+method to bring a sleeping module back to normal mode, the module says when it's ready with AUX
+so that's all we wait for. the registers didn't change, nothing is read
+*/
+
+bool EBYTE_E220::wake(unsigned long timeout) {
+
+	unsigned long t = micros();
+
+	SetPins(EBYTE_MODE_NORMAL);
+
+	if (_AUX != -1 || _pins) {
+
+		// AUX goes low while the module switches, a HIGH before that is from the old mode
+		while (getAux() == HIGH && (micros() - t) < EBYTE_WAKE_SETTLE) {
+		}
+
+		while (getAux() == LOW) {
+			if ((micros() - t) > timeout * 1000UL) {
+				EBYTE_LOGE(EBYTE_ERR_TASK_TIMEOUT, timeout);
+				EBYTE_STAT_ADD(TaskTimeouts, 1);
+				// no longer sure what the module has, let init() start over
+				_mode = EBYTE_MODE_NORMAL;
+				_sleeping = false;
+				return false;
+			}
+			yield();
+		}
+	}
+	else {
+		// no AUX, give it the usual time
+		delay(PIN_RECOVER);
+	}
+
+	_wakeTime = micros() - t;
+	_mode = EBYTE_MODE_NORMAL;
+	_sleeping = false;
+
+	EBYTE_TRACE(EBYTE_EVT_SETMODE, EBYTE_MODE_NORMAL);
+
+	return true;
+}
+
+bool EBYTE_E220::isSleeping() {
+	return _sleeping;
+}
+
+unsigned long EBYTE_E220::getWakeTime() {
+	return _wakeTime;
+}
+
+/*
+method to drive M0 and M1 (or the pin interface) for a mode
+*/
+
+void EBYTE_E220::SetPins(uint8_t mode) {
+
 	if (mode == EBYTE_MODE_NORMAL) {
 		digitalWrite(_M0, LOW);
 		digitalWrite(_M1, LOW);
@@ -143,84 +315,31 @@ void EBYTE_E220::setMode(uint8_t mode) {
 
 	}
 
-	// data sheet says 2ms later control is returned, let's give just a bit more time
-	// these modules can take time to activate pins
-	delay(PIN_RECOVER);
-
-	// clear out any junk
-	ClearBuffer();
-
-	// wait until aux pin goes back low
-	CompleteTask(4000);
-	
+	if (_pins) {
+		_pins->setMode(mode);
+	}
 }
 
 // perform a sofft reboot
 // no "Cx" commands so we need to use AT commands
 bool EBYTE_E220::reset() {
 
-	int i = 0;
-	char Response[10];
-	const char *prefix = "=";
-	size_t len = strlen(prefix);
-	setMode(MODE_PROGRAM);
-	_s->print("AT+RESET");
-	delay(100); // data sheet says 30	
-	while (_s->available()) {		
-		char c = _s->read();
-		Response[i] = c;
-		i++;
-		if (i > 9){
-			break;
-		}
-	}
-	if (strncmp(Response, prefix, len) == 0) {
-        memmove(Response, Response + len, strlen(Response + len) + 1);
-    }
-
-	delay(100); // data sheet says 30
-	setMode(EBYTE_MODE_NORMAL);
-	if (strncmp(Response, "OK", 2) == 0){
-		return true;
-	}
-	return false;
+	return ATCommand("AT+RESET", "=OK") == EBYTE_AT_OK;
 }
 
 // retore the E220 back to defaults
 // no "Cx" commands so we need to use AT commands
 bool EBYTE_E220::restoreDefaults() {
 
-	int i = 0;
-	char Response[10];
-	const char *prefix = "=";
-	size_t len = strlen(prefix);
-	setMode(MODE_PROGRAM);
-	_s->print("AT+DEFAULT");
-	delay(100); // data sheet says 30	
-	while (_s->available()) {		
-		char c = _s->read();
-		Response[i] = c;
-		i++;
-		if (i > 9){
-			break;
-		}
+	if (ATCommand("AT+DEFAULT", "=OK") != EBYTE_AT_OK){
+		return false;
 	}
-	if (strncmp(Response, prefix, len) == 0) {
-        memmove(Response, Response + len, strlen(Response + len) + 1);
-    }
 
-	delay(100); // data sheet says 30
-	setMode(EBYTE_MODE_NORMAL);
-	if (strncmp(Response, "OK", 2) == 0){
-		if (ReadParameters()){
-			return true;
-		}
-		else {
-			return false;
-		}
-	}		
+	// the default key is 0
+	CRYPT_H = 0;
+	CRYPT_L = 0;
 
-	return false;
+	return ReadParameters();
 
 }
 
@@ -420,6 +539,53 @@ uint8_t EBYTE_E220::getProductInfo(){
 float EBYTE_E220::getTransmitFrequency(){
 	return 850.125f + Channel ;	
 }	
+
+uint8_t EBYTE_E220::getPacketBytes(){
+	return EBYTE_PacketBytes(getPacketSize());
+}
+
+// time in microseconds the module needs to send some bytes with the current settings
+
+unsigned long EBYTE_E220::getAirTime(uint16_t bytes){
+	return EBYTE_AirTime(getAirDataRate(), getPacketSize(), bytes);
+}
+
+/*
+methods to estimate time on air, these don't need a module so they can be used for planning
+*/
+
+uint32_t EBYTE_AirDataRate(uint8_t adr){
+
+	switch (adr & 0b111) {
+		case ADR_4800: return 4800;
+		case ADR_9600: return 9600;
+		case ADR_19200: return 19200;
+		case ADR_38400: return 38400;
+		case ADR_62500: return 62500;
+		default: return 2400;
+	}
+}
+
+uint8_t EBYTE_PacketBytes(uint8_t sub){
+
+	switch (sub & 0b11) {
+		case SUB_128BYTES: return 128;
+		case SUB_64BYTES: return 64;
+		case SUB_32BYTES: return 32;
+		default: return 200;
+	}
+}
+
+uint32_t EBYTE_AirTime(uint8_t adr, uint8_t sub, uint16_t bytes){
+
+	uint8_t size = EBYTE_PacketBytes(sub);
+	uint32_t packets = (bytes + size - 1) / size;
+
+	// the module splits data into sub packets, each one pays the preamble and header
+	uint32_t bits = ((uint32_t) bytes + packets * EBYTE_AIR_OVERHEAD) * 8;
+
+	return (uint32_t) (((uint64_t) bits * 1000000UL) / EBYTE_AirDataRate(adr));
+}
 	
 // methods to read RSSI data 
 
@@ -432,6 +598,7 @@ int16_t EBYTE_E220::readRSSIAmbientNoise(){
 		return RSSIValue;		
 	}
 	
+	EBYTE_STAT_START(st);
 	ClearBuffer();
 	
 	_s->write(0xC0);
@@ -443,6 +610,8 @@ int16_t EBYTE_E220::readRSSIAmbientNoise(){
 	_s->readBytes((uint8_t*)& Data, (uint8_t) sizeof(Data));
 		
 	ClearBuffer();	
+	EBYTE_STAT_END(RSSI, st);
+	EBYTE_TRACE(EBYTE_EVT_RSSI, Data[0]);
 	
 	if (Data[0]== EBYTE_SUCCESS){
 		RSSIValue = Data[3];
@@ -461,6 +630,7 @@ int16_t EBYTE_E220::readRSSISignalStrength(){
 		return -999;		
 	}
 
+	EBYTE_STAT_START(st);
 	ClearBuffer();
 
 	_s->write(0xC0);
@@ -472,6 +642,8 @@ int16_t EBYTE_E220::readRSSISignalStrength(){
 	_s->readBytes((uint8_t*)& Data, (uint8_t) sizeof(Data));
 	
 	ClearBuffer();	
+	EBYTE_STAT_END(RSSI, st);
+	EBYTE_TRACE(EBYTE_EVT_RSSI, Data[0]);
 		
 	if (Data[0] == EBYTE_SUCCESS){
 		RSSIValue = (int16_t) Data[4];
@@ -502,139 +674,385 @@ void EBYTE_E220::BuildREG3() {
 }
 
 bool EBYTE_E220::getAux() {
+	if (_pins) {
+		return _pins->getAux();
+	}
 	return digitalRead(_AUX);
 }
 
+/*
+method to drive the mode and read AUX through something other than MCU pins
+call before init()
+*/
 
+void EBYTE_E220::setPins(EBYTE_E220_Pins *pins) {
+	_pins = pins;
+}
 
 /*
-method to save parameters to the module
+method to attach a receiver, once attached bytes in the serial buffer are handed to it
+whenever the library would otherwise have cleared the buffer in normal mode
 */
 
-bool EBYTE_E220::saveParameters(uint8_t val) {
-	
-	bool success = false;
-	
-#ifdef DEBUG
-	ClearBuffer();
+void EBYTE_E220::attachReceiver(EBYTE_E220_Receiver *receiver) {
+	_receiver = receiver;
+}
 
-	Serial.print("val: ");
-	Serial.println(val);
+/*
+methods to send a frame, the receiver uses the sync byte, length and crc to find frames in the stream
+keep frames no longer than getPacketBytes() if RSSI bytes are enabled as the module appends
+an RSSI byte to each sub packet
+*/
 
-	Serial.print("AddressHigh: ");
-	Serial.println(ADDH);
+bool EBYTE_E220::sendFrame(uint8_t type, const uint8_t *data, uint8_t len) {
 
-	Serial.print("AddressLow: ");
-	Serial.println(ADDL);
+	if (len > EBYTE_FRAME_MAX) {
+		return false;
+	}
 
-	Serial.print("REG0: ");
-	Serial.println(REG0);
+	WriteFrame(type, data, len);
 
-	Serial.print("REG1: ");
-	Serial.println(REG1);
+	return true;
+}
 
-	Serial.print("REG1: ");
-	Serial.println(REG1);
-	
-	Serial.print("REG2: ");
-	Serial.println(REG2);
+bool EBYTE_E220::sendFrame(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len) {
+
+	if (len > EBYTE_FRAME_MAX) {
+		return false;
+	}
 
-	Serial.print("REG3: ");
-	Serial.println(REG3);
+	// fixed point transmission, the module uses (and strips) the first 3 bytes
+	_s->write((uint8_t) (address >> 8));
+	_s->write((uint8_t) (address & 0xFF));
+	_s->write(channel);
 
-	Serial.print("CRYPT_H: ");
-	Serial.println(CRYPT_H);
+	WriteFrame(type, data, len);
 
-	Serial.print("CRYPT_L: ");
-	Serial.println(CRYPT_L);
-	
-	Serial.print("VERSION: ");
-	Serial.println(Version);
+	return true;
+}
 
-#endif
+void EBYTE_E220::WriteFrame(uint8_t type, const uint8_t *data, uint8_t len) {
 
-	setMode(MODE_PROGRAM);
+	uint8_t head[3] = {EBYTE_FRAME_SYNC, len, type};
+	uint8_t crc = EBYTE_CRC8(head + 1, 2);
+
+	crc = EBYTE_CRC8(data, len, crc);
+
+	_s->write(head, sizeof(head));
+	_s->write(data, len);
+	_s->write(crc);
+}
+
+/*
+CRC-8 (polynomial 0x07), small enough for an 8 bit MCU
+*/
+
+uint8_t EBYTE_CRC8(const uint8_t *data, uint8_t len, uint8_t crc) {
+
+	for (uint8_t i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (uint8_t b = 0; b < 8; b++) {
+			crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+
+
+/*
+method to save parameters to the module
+*/
+
+bool EBYTE_E220::saveParameters(uint8_t val) {
 	
-	Params[0] = ADDH;
-	Params[1] = ADDL;
-	Params[2] = REG0;	
-	Params[3] = REG1;
-	Params[4] = REG2;  
-	Params[5] = REG3;
-	Params[6] = CRYPT_H; 
-	Params[7] = CRYPT_L;
-	// Params[8] = PRODINFO; // read only
+	return saveRegisters(0, 8, val);
+	
+}
 
-	_s->write(val);
-	_s->write((uint8_t)0x00);
-	_s->write(0x08);
-	for ( uint8_t i = 0; i < 8; i++){			
-		_s->write(Params[i]);
+/*
+method to save only some of the registers, for example saveRegisters(4, 1, EBYTE_WRITE_TEMPORARY)
+to change just the channel. registers are numbered as in the data sheet
+0 ADDH, 1 ADDL, 2 REG0, 3 REG1, 4 REG2 (channel), 5 REG3, 6 CRYPT_H, 7 CRYPT_L
+fewer bytes on the wire means a shorter stay in program mode
+*/
+
+bool EBYTE_E220::saveRegisters(uint8_t start, uint8_t count, uint8_t val) {
+	
+	bool success = false;
+	EBYTE_STAT_START(st);
+	
+	if ((start + count) > 8 || count == 0){
+		return false;
 	}
+
+	setMode(MODE_PROGRAM);
+	
+	WriteRegisters(start, count, val);
 	
 	delay(100);
 	_s->flush();
 	delay(100);
 
-	_s->readBytes((uint8_t*)& Data, (uint8_t) sizeof(Data));	
+	// module echos C1 + start + count + the registers, we only need the first few bytes
+	_s->readBytes((uint8_t*)& Data, (uint8_t) min((uint8_t) (count + 3), (uint8_t) sizeof(Data)));	
 	// check for return of C1
 	success = false;
 	if (Data[0] == EBYTE_SUCCESS){
 		success = true;
 	}
+	else {
+		EBYTE_LOGE(EBYTE_ERR_SAVE_PARAMS, Data[0]);
+	}
 	
 	setMode(EBYTE_MODE_NORMAL);
 
+	EBYTE_STAT_END(RegWrite, st);
+	EBYTE_TRACE(EBYTE_EVT_REG_WRITE, Data[0]);
+
 	return success;
 	
 }
 
-void EBYTE_E220::restoreDefaultsByteReset(){
-	
-	ADDH = 0;
-	 ADDL = 0;
-	 REG0 = 0b01100010;	
-	 REG1 = 0b00000000;
-	 REG2 = 18;  
-	 REG3 = 0b00000000;
-	 CRYPT_H = 0; 
-	 CRYPT_L = 0;
-	
-	ClearBuffer();
+// non blocking operations and the steps they go through
+#define OP_MODE 1
+#define OP_SAVE 2
+#define OP_READ 3
+
+#define STEP_PINS 0			// waiting PIN_RECOVER before the pins change
+#define STEP_SETTLE 1		// waiting PIN_RECOVER after
+#define STEP_AUX 2			// waiting for AUX to go high
+#define STEP_REPLY 3		// program mode command sent, waiting for the answer
 
-	Serial.print("AddressHigh: ");
-	Serial.println(ADDH);
+/*
+method to start a mode change without blocking, the same steps as setMode() but poll() moves
+from one to the next when its time is up instead of waiting in delay()
+*/
 
-	Serial.print("AddressLow: ");
-	Serial.println(ADDL);
+bool EBYTE_E220::startMode(uint8_t mode) {
 
-	Serial.print("REG0: ");
-	Serial.println(REG0);
+	if (_opStatus == EBYTE_OP_BUSY) {
+		return false;
+	}
 
-	Serial.print("REG1: ");
-	Serial.println(REG1);
+	_op = OP_MODE;
+	_opMode = mode;
+	_opStep = STEP_PINS;
+	_opTime = millis();
+	_opOk = true;
+	_opStatus = EBYTE_OP_BUSY;
 
-	Serial.print("REG1: ");
-	Serial.println(REG1);
-	
-	Serial.print("REG2: ");
-	Serial.println(REG2);
+	return true;
+}
 
-	Serial.print("REG3: ");
-	Serial.println(REG3);
+/*
+method to start a register write without blocking, set the values first as for saveRegisters()
+the module goes to program mode, gets the registers and goes back to normal mode
+*/
 
-	Serial.print("CRYPT_H: ");
-	Serial.println(CRYPT_H);
+bool EBYTE_E220::startSave(uint8_t start, uint8_t count, uint8_t val) {
 
-	Serial.print("CRYPT_L: ");
-	Serial.println(CRYPT_L);
-	
-	Serial.print("VERSION: ");
-	Serial.println(Version);
+	if ((start + count) > 8 || count == 0) {
+		return false;
+	}
 
+	if (!startMode(MODE_PROGRAM)) {
+		return false;
+	}
+
+	_op = OP_SAVE;
+	_opStart = start;
+	_opCount = count;
+	_opVal = val;
+
+	return true;
+}
+
+/*
+method to start reading the registers back without blocking, the values are updated when it's done
+*/
+
+bool EBYTE_E220::startRead() {
+
+	if (!startMode(MODE_PROGRAM)) {
+		return false;
+	}
+
+	_op = OP_READ;
+
+	return true;
+}
+
+/*
+method to move the operation along, call it as often as you can
+*/
+
+uint8_t EBYTE_E220::poll() {
+
+	if (_opStatus != EBYTE_OP_BUSY) {
+		return _opStatus;
+	}
+
+	unsigned long now = millis();
+
+	switch (_opStep) {
+
+	case STEP_PINS:
+		if ((now - _opTime) < PIN_RECOVER) {
+			break;
+		}
+		// hand the receiver what has arrived so far, the answers to program mode commands aren't for it
+		ClearBuffer();
+		if (_receiver && _opMode == MODE_PROGRAM) {
+			_receiver->pause(true);
+		}
+		SetPins(_opMode);
+		_opTime = now;
+		_opStep = STEP_SETTLE;
+		break;
+
+	case STEP_SETTLE:
+		if ((now - _opTime) < PIN_RECOVER) {
+			break;
+		}
+		ClearBuffer();
+		_mode = _opMode;
+		_sleeping = false;
+		if (_receiver && _mode != MODE_PROGRAM) {
+			_receiver->pause(false);
+		}
+		_opTime = now;
+		_opStep = STEP_AUX;
+		break;
+
+	case STEP_AUX:
+		if (_AUX != -1 || _pins) {
+			if (getAux() == LOW) {
+				if ((now - _opTime) <= 4000) {
+					break;
+				}
+				EBYTE_LOGE(EBYTE_ERR_TASK_TIMEOUT, now - _opTime);
+				EBYTE_STAT_ADD(TaskTimeouts, 1);
+			}
+		}
+		else if ((now - _opTime) < 4000) {
+			break;
+		}
+		EBYTE_TRACE(EBYTE_EVT_SETMODE, _mode);
+		OpModeDone();
+		break;
+
+	case STEP_REPLY:
+		if (_s->available() < _opWant && (now - _opTime) < EBYTE_OP_REPLY) {
+			break;
+		}
+		OpReply();
+		break;
+	}
+
+	return _opStatus;
+}
+
+/*
+method to go on once a mode change is through, in program mode send the command, back in normal
+mode the operation is over
+*/
+
+void EBYTE_E220::OpModeDone() {
+
+	if (_op == OP_MODE || _mode != MODE_PROGRAM) {
+		_opStatus = _opOk ? EBYTE_OP_DONE : EBYTE_OP_FAILED;
+		return;
+	}
+
+	if (_op == OP_SAVE) {
+
+		WriteRegisters(_opStart, _opCount, _opVal);
+
+		// module echos C1 + start + count + the registers
+		_opWant = _opCount + 3;
+	}
+	else {
+		_s->write(EBYTE_READ);
+		_s->write((uint8_t) 0);
+		_s->write((uint8_t) 0x0b);
+		_opWant = sizeof(Params);
+	}
+
+	_opTime = millis();
+	_opStep = STEP_REPLY;
+}
+
+/*
+method to check the module's answer and go back to normal mode
+*/
+
+void EBYTE_E220::OpReply() {
+
+	uint8_t n = 0;
+
+	if (_op == OP_SAVE) {
+		while (n < sizeof(Data) && _s->available()) {
+			Data[n++] = _s->read();
+		}
+		_opOk = n > 0 && Data[0] == EBYTE_SUCCESS;
+		if (!_opOk) {
+			EBYTE_LOGE(EBYTE_ERR_SAVE_PARAMS, n ? Data[0] : 0);
+		}
+		EBYTE_TRACE(EBYTE_EVT_REG_WRITE, n ? Data[0] : 0);
+	}
+	else {
+		while (n < sizeof(Params) && _s->available()) {
+			Params[n++] = _s->read();
+		}
+		_opOk = n == sizeof(Params) && Params[0] == EBYTE_READ;
+		if (_opOk) {
+			for (uint8_t i = 3; i < sizeof(Params); i++){
+				EBYTE_LOGD(EBYTE_LOG_REG_READ, ((i - 3) << 8) | Params[i]);
+			}
+			KeepKey();
+			ParseParameters();
+		}
+		else {
+			EBYTE_LOGE(EBYTE_ERR_READ_PARAMS, n ? Params[0] : 0);
+		}
+		EBYTE_TRACE(EBYTE_EVT_REG_READ, n ? Params[0] : 0);
+	}
+
+	// rest of the answer is thrown away with the mode change
+	_opMode = EBYTE_MODE_NORMAL;
+	_opStep = STEP_PINS;
+	_opTime = millis();
+}
+
+/*
+method to send the write command for registers start to start + count - 1 from the register
+variables, saveRegisters() and startSave() both write through here
+*/
+
+void EBYTE_E220::WriteRegisters(uint8_t start, uint8_t count, uint8_t val) {
+
+	BuildParams();
+
+	for (uint8_t i = start; i < start + count; i++){
+		EBYTE_LOGD(EBYTE_LOG_REG_WRITE, (i << 8) | Params[i]);
+	}
+
+	_s->write(val);
+	_s->write(start);
+	_s->write(count);
+	for (uint8_t i = start; i < start + count; i++){
+		_s->write(Params[i]);
+	}
+}
+
+/*
+method to copy the register variables into the 8 byte image sent to the module
+*/
+
+void EBYTE_E220::BuildParams() {
 
-	setMode(MODE_PROGRAM);
-	
 	Params[0] = ADDH;
 	Params[1] = ADDL;
 	Params[2] = REG0;	
@@ -643,6 +1061,30 @@ void EBYTE_E220::restoreDefaultsByteReset(){
 	Params[5] = REG3;
 	Params[6] = CRYPT_H; 
 	Params[7] = CRYPT_L;
+	// Params[8] = PRODINFO; // read only
+}
+
+void EBYTE_E220::restoreDefaultsByteReset(){
+	
+	ADDH = 0;
+	 ADDL = 0;
+	 REG0 = 0b01100010;	
+	 REG1 = 0b00000000;
+	 REG2 = 18;  
+	 REG3 = 0b00000000;
+	 CRYPT_H = 0; 
+	 CRYPT_L = 0;
+	
+	EBYTE_STAT_START(st);
+	ClearBuffer();
+
+	setMode(MODE_PROGRAM);
+	
+	BuildParams();
+
+	for (uint8_t i = 0; i < 8; i++){
+		EBYTE_LOGD(EBYTE_LOG_REG_WRITE, (i << 8) | Params[i]);
+	}
 
 	_s->write(EBYTE_WRITE_PERMANENT);
 	_s->write((uint8_t)0x00);
@@ -660,9 +1102,24 @@ void EBYTE_E220::restoreDefaultsByteReset(){
 
 
 	setMode(EBYTE_MODE_NORMAL);
+
+	EBYTE_STAT_END(RegWrite, st);
+	EBYTE_TRACE(EBYTE_EVT_REG_WRITE, Data[0]);
 	
 }
 
+#ifdef EBYTE_E220_STATS
+
+/*
+method to get the operation counters and trace
+*/
+
+EBYTE_Stats *EBYTE_E220::getStats() {
+	return &Stats;
+}
+
+#endif
+
 /*
 method to print parameters, this can be called anytime after init(), because init gets parameters
 and any method updates the variables
@@ -713,6 +1170,7 @@ method to read parameters,
 
 bool EBYTE_E220::ReadParameters() {
 	uint8_t ZERO = 0;
+	EBYTE_STAT_START(st);
 	ClearBuffer();
 
 	setMode(MODE_PROGRAM);
@@ -724,24 +1182,40 @@ bool EBYTE_E220::ReadParameters() {
 	
 	_s->readBytes((uint8_t*)& Params, (uint8_t) sizeof(Params));
 	
+	EBYTE_STAT_END(RegRead, st);
+	EBYTE_TRACE(EBYTE_EVT_REG_READ, Params[0]);
+
 	if (EBYTE_READ != Params[0]){
 		return false;
 	}
 	
-	#ifdef DEBUG
-	for (uint8_t i = 0; i < sizeof(Params); i++){
-		Serial.print(i);
-		Serial.print(" - ");
-		Serial.print(Params[i], DEC);
-		Serial.print(" - ");
-		Serial.print(Params[i], BIN);
-		Serial.print(" - ");
-		Serial.println(Params[i], HEX);
+	// register values start after the C1 00 0B header
+	for (uint8_t i = 3; i < sizeof(Params); i++){
+		EBYTE_LOGD(EBYTE_LOG_REG_READ, ((i - 3) << 8) | Params[i]);
 	}
-	#endif
 
 	setMode(EBYTE_MODE_NORMAL);
 
+	KeepKey();
+	ParseParameters();
+
+	return true;
+	
+}
+
+// the key registers are write only and read back as 0, keep the key we last set instead
+// so the next saveParameters() doesn't clear it
+
+void EBYTE_E220::KeepKey() {
+
+	Params[9] = CRYPT_H;
+	Params[10] = CRYPT_L;
+}
+
+// split the register image in Params (after the C1 00 0B header) into the individual settings
+
+void EBYTE_E220::ParseParameters() {
+
 	ADDH =  Params[3];
 	ADDL =  Params[4];
 	REG0 = Params[5];	
@@ -771,11 +1245,47 @@ bool EBYTE_E220::ReadParameters() {
 	REG3_TransmitMethod = getTransmissionMethod();
 	REG3_LBTEnable = getLBTEnable();
 	REG3_WOR = getWORTIming();
+}
 
+/*
+method to send an AT command and parse the response as it streams in
+the module must be in program mode for AT commands, this method handles the mode switching
+returns one of the EBYTE_AT_xxx status codes
+*/
 
-	
-	return true;
-	
+uint8_t EBYTE_E220::ATCommand(const char *cmd, const char *key, char *val, uint8_t size) {
+
+	EBYTE_ATParser Parser;
+	uint8_t status = EBYTE_AT_PENDING;
+	EBYTE_STAT_START(st);
+
+	Parser.begin(key, val, size);
+	setMode(MODE_PROGRAM);
+	_s->print(cmd);
+
+	unsigned long t = millis();
+
+	// consume bytes as they arrive, no fixed sleep--we're done as soon as the line is. the timeout
+	// is checked on every pass so a line that keeps sending what the parser doesn't accept ends too
+	while (status == EBYTE_AT_PENDING) {
+		if (_s->available()) {
+			status = Parser.feed(_s->read());
+		}
+		else {
+			yield();
+		}
+		if (status == EBYTE_AT_PENDING && (millis() - t) > AT_TIMEOUT) {
+			status = Parser.finish();
+		}
+	}
+
+	setMode(EBYTE_MODE_NORMAL);
+
+	EBYTE_STAT_END(ATCommand, st);
+	EBYTE_TRACE(EBYTE_EVT_AT, status);
+
+	_atStatus = status;
+	return status;
 }
 
 // the "C1" method for getting model and version are not supported
@@ -783,29 +1293,10 @@ bool EBYTE_E220::ReadParameters() {
 
 bool EBYTE_E220::ReadModel() {
 
-	int i = 0;
-	const char *prefix = "DEVTYPE=";
-    size_t len = strlen(prefix);	
-	setMode(MODE_PROGRAM);
-	_s->print("AT+DEVTYPE=?\r\n");
-	delay(100); // data sheet says 30	
-	_s->flush();
-	while (_s->available()) {		
-		char c = _s->read();
-		if (c == '\n'){			
-			break;
-		}
-		Model[i] = c;
-		i++;
-		if (i > 29){
-			break;
-		}
+	if (ATCommand("AT+DEVTYPE=?\r\n", "DEVTYPE=", Model, sizeof(Model)) != EBYTE_AT_OK){
+		return false;
 	}
-	delay(100); // data sheet says 30
-	setMode(EBYTE_MODE_NORMAL);
-    if (strncmp(Model, prefix, len) == 0) {
-        memmove(Model, Model + len, strlen(Model + len) + 1);
-    }	
+
 	// simple check to see if this is an E220
 	if (strncmp(Model, "E220", 4) == 0){
 		return true;
@@ -820,32 +1311,119 @@ bool EBYTE_E220::ReadModel() {
 
 bool EBYTE_E220::ReadVersion() {
 
-	int i = 0;
-	const char *prefix = "FWCODE=";
-    size_t len = strlen(prefix);	
-	setMode(MODE_PROGRAM);
-	_s->print("AT+FWCODE=?\r\n");	
-	delay(100); // data sheet says 30	
-	_s->flush();
-	while (_s->available()) {		
-		char c = _s->read();
-		if (c == '\n'){			
-			break;
+	ATCommand("AT+FWCODE=?\r\n", "FWCODE=", Version, sizeof(Version));
+
+	return true; // maybe someday I'll add some checker but version really doesn't matter
+	
+}
+
+
+/*
+AT response parser
+*/
+
+void EBYTE_ATParser::begin(const char *key, char *val, uint8_t size) {
+
+	_key = key;
+	_val = val;
+	_size = size;
+	_len = 0;
+	_keyPos = 0;
+	_errPos = 0;
+	_found = false;
+	_error = false;
+	_overflow = false;
+	_status = EBYTE_AT_PENDING;
+
+	if (_val && _size) {
+		_val[0] = '\0';
+	}
+}
+
+// advance a running match of pattern by one character, returns the new match position
+uint8_t EBYTE_ATParser::Match(const char *pattern, uint8_t pos, char c) {
+
+	if (c == pattern[pos]) {
+		return pos + 1;
+	}
+	return (c == pattern[0]) ? 1 : 0;
+}
+
+uint8_t EBYTE_ATParser::feed(char c) {
+
+	if (_status != EBYTE_AT_PENDING) {
+		return _status;
+	}
+
+	if (c == '\r') {
+		return _status;
+	}
+
+	if (c == '\n') {
+		if (_found || _error) {
+			return finish();
 		}
-		Version[i] = c;
-		i++;
-		if (i > 29){
-			break;
+		// line without our key (echo or blank), start over on the next one
+		_keyPos = 0;
+		_errPos = 0;
+		return _status;
+	}
+
+	if (_found) {
+		if (_len < _size - 1) {
+			_val[_len++] = c;
+			_val[_len] = '\0';
 		}
+		else {
+			_overflow = true;
+		}
+		return _status;
 	}
-	delay(100); // data sheet says 30
-	setMode(EBYTE_MODE_NORMAL);
 
-	if (strncmp(Version, prefix, len) == 0) {
-        memmove(Version, Version + len, strlen(Version + len) + 1);
-    }	
-	return true; // maybe someday I'll add some checker but version really doesn't matter
-	
+	_errPos = Match("ERR", _errPos, c);
+	if (_errPos == 3) {
+		_error = true;
+		_errPos = 0;
+	}
+
+	// the key has to start the line, anything else is an echo or noise
+	if (_keyPos == 0xFF) {
+		return _status;
+	}
+	_keyPos = (c == _key[_keyPos]) ? _keyPos + 1 : 0xFF;
+	if (_keyPos != 0xFF && _key[_keyPos] == '\0') {
+		_found = true;
+		// nothing to collect, no need to wait for the end of the line
+		if (!_val || !_size) {
+			return finish();
+		}
+	}
+
+	return _status;
+}
+
+// called at the line terminator or when the caller gives up waiting
+uint8_t EBYTE_ATParser::finish() {
+
+	if (_status != EBYTE_AT_PENDING) {
+		return _status;
+	}
+
+	if (_found) {
+		_status = _overflow ? EBYTE_AT_OVERFLOW : EBYTE_AT_OK;
+	}
+	else if (_error) {
+		_status = EBYTE_AT_ERROR;
+	}
+	else {
+		_status = EBYTE_AT_TIMEOUT;
+	}
+
+	return _status;
+}
+
+uint8_t EBYTE_ATParser::getStatus() {
+	return _status;
 }
 
 
@@ -857,18 +1435,34 @@ without clearing the buffer, i find getting the parameters very unreliable after
 i suspect stuff in the buffer affects rogramming 
 hence, let's clean it out
 this is called as part of the setmode
+if a receiver is attached and the module is in a data mode the bytes are given to the receiver instead
 
 */
 void EBYTE_E220::ClearBuffer(){
 
+	// in the data modes what's in the buffer is received data, keep it if someone wants it
+	// a paused receiver won't take it, the pins are already on their way to program mode
+	if (_receiver && _mode != MODE_PROGRAM && !_receiver->isPaused()) {
+		_receiver->drain();
+		return;
+	}
+
 	unsigned long amt = millis();
-_s->flush();
+	unsigned long discarded = 0;
+
+	_s->flush();
 	while(_s->available()) {
 		_s->read();
+		discarded++;
 		if ((millis() - amt) > 5000) {
-          Serial.println("FAIL EBYTE_E220::ClearBuffer()");
-          break;
-        }
+			EBYTE_LOGE(EBYTE_ERR_CLEAR_TIMEOUT, discarded);
+			break;
+		}
+	}
+
+	if (discarded) {
+		EBYTE_STAT_ADD(BytesDiscarded, discarded);
+		EBYTE_TRACE(EBYTE_EVT_CLEAR, discarded);
 	}
 
 }
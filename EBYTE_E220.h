@@ -66,8 +66,6 @@
 */
 
 
-// #define DEBUG
-
 #ifndef EBYTE_E220_H_LIB
 #define EBYTE_E220_H_LIB
 
@@ -79,6 +77,14 @@
 #include "WProgram.h"
 #endif
 
+// the library reports errors through EBYTE_E220_Log.h and never prints on its own
+// to see diagnostics install a sink, for example EBYTE_setLogSink(EBYTE_LogToSerial);
+// set EBYTE_LOG_LEVEL to EBYTE_LOG_DEBUG in that file to also see the register values
+#include "EBYTE_E220_Log.h"
+
+// operation counters and trace, off unless EBYTE_E220_STATS is defined in that file
+#include "EBYTE_E220_Stats.h"
+
 
 // if you seem to get "corrupt settings add this line to your .ino
 // #include <avr/io.h>
@@ -94,6 +100,10 @@ if your unit will not return parameter settings.
 
 #define PIN_RECOVER 50 
 
+// AT commands (model, version, reset, defaults) answer within 30 ms per the data sheet
+// this is the most we'll wait for the line terminator before giving up
+#define AT_TIMEOUT 500
+
 // modes NORMAL send and recieve for example
 #define EBYTE_MODE_NORMAL 0			// can send and recieve
 #define MODE_WAKEUP 1			// sends a preamble to waken receiver
@@ -104,6 +114,25 @@ if your unit will not return parameter settings.
 #define EBYTE_SUCCESS  0xC1
 #define EBYTE_WRITE_PERMANENT  0xC0
 #define EBYTE_WRITE_TEMPORARY  0xC2
+
+// AT command response status
+#define EBYTE_AT_PENDING 0		// still collecting the response line
+#define EBYTE_AT_OK 1			// key found, value (if any) copied
+#define EBYTE_AT_ERROR 2		// module answered with ERR
+#define EBYTE_AT_TIMEOUT 3		// no terminator and no key before AT_TIMEOUT
+#define EBYTE_AT_OVERFLOW 4		// key found but value truncated to fit the buffer
+
+// status of the non blocking operations (startMode(), startSave(), startRead()) from poll()
+#define EBYTE_OP_IDLE 0			// nothing started
+#define EBYTE_OP_BUSY 1			// keep calling poll()
+#define EBYTE_OP_DONE 2
+#define EBYTE_OP_FAILED 3		// no reply from the module, or not what we asked for
+
+// most we'll wait for the module to answer a register read or write in program mode
+#define EBYTE_OP_REPLY 1000
+
+// after the pins change for wake() AUX drops within this long (us), until then a HIGH is the old state
+#define EBYTE_WAKE_SETTLE 3000
 	
 //UART data rates
 // (can be different for transmitter and reveiver)
@@ -165,7 +194,89 @@ if your unit will not return parameter settings.
 #define OPT_WAKEUP3500 0b110
 #define OPT_WAKEUP4000 0b111
 
+// per sub packet overhead (preamble and LoRa header) in byte times at the air data rate
+// this is an estimate used for timing, measure your own link if you need exact figures
+#define EBYTE_AIR_OVERHEAD 16
+
+// methods to estimate time on air
+uint32_t EBYTE_AirDataRate(uint8_t adr);						// ADR_xxx to bits per second
+uint8_t EBYTE_PacketBytes(uint8_t sub);							// SUB_xxx to bytes
+uint32_t EBYTE_AirTime(uint8_t adr, uint8_t sub, uint16_t bytes);	// microseconds to send bytes
+
+// frames sent with sendFrame(), sync + length + type + payload + crc8
+// the receiver in EBYTE_E220_Receiver.h finds them in the byte stream
+#define EBYTE_FRAME_SYNC 0xE2
+#define EBYTE_FRAME_OVERHEAD 4
+#define EBYTE_FRAME_MAX (200 - EBYTE_FRAME_OVERHEAD)
+
+// frame types, 0x00 - 0x7F are free for your own use, the library's layers use the rest
+#define EBYTE_FRAME_DATA 0x00
+#define EBYTE_FRAME_ARQ_DATA 0x80	// EBYTE_E220_ARQ.h
+#define EBYTE_FRAME_ARQ_ACK 0x81
+#define EBYTE_FRAME_PACKED 0x82		// EBYTE_E220_Codec.h
+#define EBYTE_FRAME_FEC 0x83		// EBYTE_E220_FEC.h
+#define EBYTE_FRAME_LINK 0x84		// EBYTE_E220_LinkTest.h
+#define EBYTE_FRAME_ADAPT 0x85		// EBYTE_E220_Adapt.h
+#define EBYTE_FRAME_FRAG 0x86		// EBYTE_E220_TxQueue.h
+#define EBYTE_FRAME_POLL 0x87		// EBYTE_E220_TDMA.h
+#define EBYTE_FRAME_RELAY 0x88		// EBYTE_E220_Relay.h
+#define EBYTE_FRAME_KEY 0x89		// EBYTE_E220_Keys.h
+#define EBYTE_FRAME_BATCH 0x8A		// EBYTE_E220_Batch.h
+#define EBYTE_FRAME_RAW 0xFF		// fixed size frames with no header (see EBYTE_E220_Receiver::setFrameSize)
+
+uint8_t EBYTE_CRC8(const uint8_t *data, uint8_t len, uint8_t crc = 0);
+
 class Stream;
+class EBYTE_E220_Receiver;
+
+/*
+optional replacement for the M0, M1 and AUX pins, for example a port expander or the
+module simulator in EBYTE_E220_Sim.h. normally not needed
+*/
+
+class EBYTE_E220_Pins {
+
+public:
+
+	virtual ~EBYTE_E220_Pins() {}
+	virtual void setMode(uint8_t mode) = 0;
+	virtual bool getAux() = 0;
+
+};
+
+/*
+incremental parser for AT command responses, bytes are fed one at a time as they arrive
+the parser looks for a key (for example "DEVTYPE=" or "=OK") at the start of a line and copies
+whatever follows it up to the line terminator into a caller supplied buffer (always NUL terminated)
+lines that don't start with the key (echo, blank lines) are skipped
+if no value buffer is given the response is complete as soon as the key is matched
+*/
+
+class EBYTE_ATParser {
+
+public:
+
+	void begin(const char *key, char *val = NULL, uint8_t size = 0);
+	uint8_t feed(char c);
+	uint8_t finish();
+	uint8_t getStatus();
+
+private:
+
+	uint8_t Match(const char *pattern, uint8_t pos, char c);
+
+	const char *_key;
+	char *_val;
+	uint8_t _size;
+	uint8_t _len;
+	uint8_t _keyPos;
+	uint8_t _errPos;
+	bool _found;
+	bool _error;
+	bool _overflow;
+	uint8_t _status;
+
+};
 
 class EBYTE_E220 {
 
@@ -181,9 +292,18 @@ public:
 	// so you know what the non changed parameters are know for resending back
 
 	bool init();
+	bool init(const uint8_t *image, uint8_t mode = EBYTE_MODE_NORMAL);	// from getRegisters(), no reads
 	
 	// methods to set modules working parameters NOTHING WILL BE SAVED UNLESS SaveParameters() is called
 	void setMode(uint8_t mode = EBYTE_MODE_NORMAL);
+
+	// power down between samples and back, registers are kept on both sides so there is nothing to
+	// read again, wake() waits only for AUX. init() after sleep() just wakes the module, or does the
+	// full init if it doesn't wake
+	void sleep();
+	bool wake(unsigned long timeout = 1000);
+	bool isSleeping();
+	unsigned long getWakeTime();			// us from the pins changing to AUX ready, last wake()
 	void setAddress(uint16_t val = 0);
 	void setAddressH(uint8_t val = 0);
 	void setAddressL(uint8_t val = 0);
@@ -202,6 +322,14 @@ public:
 	void setEncryptonH(uint8_t val);
 	void setEncryptonL(uint8_t val);		
 	bool getAux();
+	void setPins(EBYTE_E220_Pins *pins);
+
+	// hand received data to a receiver instead of throwing it away during mode changes
+	void attachReceiver(EBYTE_E220_Receiver *receiver);
+
+	// methods to send a frame (see EBYTE_E220_Receiver.h), the second is for fixed point transmission
+	bool sendFrame(uint8_t type, const uint8_t *data, uint8_t len);
+	bool sendFrame(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len);
 	
 	// methods to get module data
 	char *getModel();
@@ -225,6 +353,11 @@ public:
 	bool getLBTEnable();
 	uint8_t getWORTIming();	
 	float getTransmitFrequency();	
+	uint8_t getPacketBytes();
+	unsigned long getAirTime(uint16_t bytes);
+	uint8_t getMode();
+	void getRegisters(uint8_t *image);		// 8 bytes, ADDH to CRYPT_L
+	void setRegisters(const uint8_t *image);	// all the setters at once, saved as usual
 	
 	int16_t readRSSIAmbientNoise();	
 	int16_t readRSSISignalStrength();
@@ -236,6 +369,15 @@ public:
 	// notion here is you can set several but save once as opposed to saving on each parameter change
 	// you can save permanently (retained at start up, or temp which is ideal for dynamically changing the address or frequency
 	bool saveParameters(uint8_t val = EBYTE_WRITE_PERMANENT);
+	bool saveRegisters(uint8_t start, uint8_t count, uint8_t val = EBYTE_WRITE_PERMANENT);
+
+	// the same without blocking, start one and call poll() from loop() until it stops returning
+	// EBYTE_OP_BUSY. only one at a time per module, and don't call the blocking methods meanwhile
+	// EBYTE_E220_Manager.h runs several modules this way at once
+	bool startMode(uint8_t mode);
+	bool startSave(uint8_t start, uint8_t count, uint8_t val = EBYTE_WRITE_PERMANENT);
+	bool startRead();
+	uint8_t poll();
 	
 	// soft rebool
 	bool reset();
@@ -245,17 +387,31 @@ public:
 	
 	void restoreDefaultsByteReset();
 
+#ifdef EBYTE_E220_STATS
+	// operation counters and recent events, see EBYTE_E220_Stats.h
+	EBYTE_Stats *getStats();
+#endif
+
 private:
 
 	bool ReadParameters();
+	void ParseParameters();
+	void KeepKey();
+	uint8_t ATCommand(const char *cmd, const char *key, char *val = NULL, uint8_t size = 0);
 	bool ReadModel();
 	bool ReadVersion();
 	void ClearBuffer();
 	void BuildREG0();
 	void BuildREG1();		
 	void BuildREG3();
+	void BuildParams();
+	void WriteRegisters(uint8_t start, uint8_t count, uint8_t val);
+	void WriteFrame(uint8_t type, const uint8_t *data, uint8_t len);
 	// method to let method know of module is busy doing something (timeout provided to avoid lockups)
 	void CompleteTask(unsigned long timeout = 0);
+	void SetPins(uint8_t mode);
+	void OpModeDone();
+	void OpReply();
 	
 	// variable for the serial stream
 	Stream*  _s;
@@ -264,6 +420,24 @@ private:
 	int8_t _M0;
 	int8_t _M1;
 	int8_t _AUX;
+	EBYTE_E220_Pins *_pins;
+	EBYTE_E220_Receiver *_receiver;
+	uint8_t _mode;
+	uint8_t _atStatus;		// status of the last ATCommand()
+	bool _sleeping;
+	unsigned long _wakeTime;
+
+	// non blocking operation in progress
+	uint8_t _op;
+	uint8_t _opStep;
+	uint8_t _opMode;
+	uint8_t _opStart;
+	uint8_t _opCount;
+	uint8_t _opVal;
+	uint8_t _opWant;
+	uint8_t _opStatus;
+	bool _opOk;
+	unsigned long _opTime;
 
 	// variable for the 6 bytes that are sent to the module to program it
 	// or bytes received to indicate modules programmed settings
@@ -314,6 +488,10 @@ private:
 	uint8_t buf;
 	uint8_t ProductInfo;
 
+#ifdef EBYTE_E220_STATS
+	EBYTE_Stats Stats;
+#endif
+
 };
 
 #endif
@@ -0,0 +1,359 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_ARQ.h>
+
+EBYTE_E220_ARQ::EBYTE_E220_ARQ(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_handler = NULL;
+	_ctx = NULL;
+	_fixed = false;
+	_address = 0;
+	_channel = 0;
+	_timeout = 1000;
+	_ackDelay = 100;
+	_txBase = 0;
+	_txNext = 0;
+	_rxNext = 0;
+	_ackPending = false;
+	_lastData = 0;
+	_skipPending = false;
+	_skipTo = 0;
+	_skipTries = 0;
+	_skipSent = 0;
+	_sent = 0;
+	_retransmits = 0;
+	_delivered = 0;
+	_dropped = 0;
+	_skipped = 0;
+
+	memset(_tx, 0, sizeof(_tx));
+	memset(_rx, 0, sizeof(_rx));
+}
+
+bool EBYTE_E220_ARQ::begin() {
+
+	updateTimers();
+
+	return _receiver->onFrame(DataHandler, this, EBYTE_FRAME_ARQ_DATA) &&
+		_receiver->onFrame(AckHandler, this, EBYTE_FRAME_ARQ_ACK);
+}
+
+/*
+work out the timers from the radio settings
+the receiver acks once the data has stopped for a bit longer than one frame takes on air
+the sender resends if no ack came back by the time a whole window, the ack delay and the ack could have been sent
+*/
+
+void EBYTE_E220_ARQ::updateTimers() {
+
+	unsigned long frame = _radio->getAirTime(EBYTE_FRAME_OVERHEAD + EBYTE_ARQ_HEADER + EBYTE_ARQ_PAYLOAD) / 1000;
+	unsigned long ack = _radio->getAirTime(EBYTE_FRAME_OVERHEAD + 5) / 1000;
+
+	_ackDelay = frame + EBYTE_ARQ_GUARD;
+	_timeout = (EBYTE_ARQ_WINDOW * frame) + _ackDelay + ack + (2 * EBYTE_ARQ_GUARD);
+}
+
+void EBYTE_E220_ARQ::setPeer(uint16_t address, uint8_t channel) {
+	_fixed = true;
+	_address = address;
+	_channel = channel;
+}
+
+void EBYTE_E220_ARQ::onReceive(EBYTE_ARQHandler handler, void *ctx) {
+	_handler = handler;
+	_ctx = ctx;
+}
+
+bool EBYTE_E220_ARQ::send(const uint8_t *data, uint8_t len) {
+
+	if (len > EBYTE_ARQ_PAYLOAD || pending() >= EBYTE_ARQ_WINDOW) {
+		return false;
+	}
+
+	TxSlot *slot = &_tx[_txNext % EBYTE_ARQ_WINDOW];
+
+	slot->Data[0] = _txNext;
+	memcpy(slot->Data + EBYTE_ARQ_HEADER, data, len);
+	slot->Len = len + EBYTE_ARQ_HEADER;
+	slot->Tries = 0;
+	slot->Acked = false;
+	slot->Sent = 0;
+
+	_txNext++;
+
+	return true;
+}
+
+/*
+at most one frame per call and only while the module is idle, so we never overrun its buffer
+acks go first, then new or timed out messages, oldest first
+*/
+
+void EBYTE_E220_ARQ::service() {
+
+	unsigned long now = millis();
+
+	if (!_radio->getAux()) {
+		return;
+	}
+
+	if (_ackPending && (now - _lastData) >= _ackDelay) {
+		SendAck();
+		return;
+	}
+
+	for (uint8_t seq = _txBase; seq != _txNext; seq++) {
+
+		TxSlot *slot = &_tx[seq % EBYTE_ARQ_WINDOW];
+
+		if (slot->Acked || (slot->Tries && (now - slot->Sent) < _timeout)) {
+			continue;
+		}
+
+		if (slot->Tries >= EBYTE_ARQ_RETRIES) {
+			// give up, the base we send from now on tells the receiver not to wait for it
+			slot->Acked = true;
+			_dropped++;
+			Advance();
+			_skipPending = true;
+			_skipTo = seq + 1;
+			_skipTries = 0;
+			_skipSent = now - _timeout;
+			continue;
+		}
+
+		if (slot->Tries) {
+			_retransmits++;
+		}
+		slot->Data[1] = _txBase;
+		slot->Tries++;
+		slot->Sent = now;
+		_sent++;
+		SendFrame(EBYTE_FRAME_ARQ_DATA, slot->Data, slot->Len);
+		return;
+	}
+
+	// nothing went out to carry the base past what was given up on, the receiver would hold
+	// what it has beyond the gap until the next message. send the base on its own until the
+	// ack shows it moved on
+	if (_skipPending && (now - _skipSent) >= _timeout) {
+		if (_skipTries++ >= EBYTE_ARQ_RETRIES) {
+			_skipPending = false;
+			return;
+		}
+		SendBase();
+		_skipSent = now;
+	}
+}
+
+uint8_t EBYTE_E220_ARQ::pending() {
+	return (uint8_t) (_txNext - _txBase);
+}
+
+unsigned long EBYTE_E220_ARQ::getTimeout() {
+	return _timeout;
+}
+
+uint32_t EBYTE_E220_ARQ::getSent() {
+	return _sent;
+}
+
+uint32_t EBYTE_E220_ARQ::getRetransmits() {
+	return _retransmits;
+}
+
+uint32_t EBYTE_E220_ARQ::getDelivered() {
+	return _delivered;
+}
+
+uint32_t EBYTE_E220_ARQ::getDropped() {
+	return _dropped;
+}
+
+uint32_t EBYTE_E220_ARQ::getSkipped() {
+	return _skipped;
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_ARQ::DataHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_ARQ*) ctx)->GotData(data, len);
+}
+
+void EBYTE_E220_ARQ::AckHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_ARQ*) ctx)->GotAck(data, len);
+}
+
+void EBYTE_E220_ARQ::GotData(uint8_t *data, uint8_t len) {
+
+	if (len < EBYTE_ARQ_HEADER) {
+		return;
+	}
+
+	uint8_t seq = data[0];
+	uint8_t base = data[1];
+	// a message is never numbered before the base, one that is only carries the base (SendBase())
+	bool message = seq != (uint8_t) (base - 1);
+
+	// the sender gave up on something before base, stop waiting for it
+	while ((uint8_t) (base - _rxNext) < 128 && base != _rxNext) {
+		RxSlot *slot = &_rx[_rxNext % EBYTE_ARQ_WINDOW];
+		if (slot->Full) {
+			if (_handler) {
+				_handler(slot->Data, slot->Len, _ctx);
+			}
+			_delivered++;
+			slot->Full = false;
+		}
+		else {
+			_skipped++;
+		}
+		_rxNext++;
+	}
+
+	// inside the window, keep it (duplicates and old messages just get acked again)
+	if (message && (uint8_t) (seq - _rxNext) < EBYTE_ARQ_WINDOW) {
+		RxSlot *slot = &_rx[seq % EBYTE_ARQ_WINDOW];
+		if (!slot->Full) {
+			slot->Len = min((uint8_t) (len - EBYTE_ARQ_HEADER), (uint8_t) EBYTE_ARQ_PAYLOAD);
+			memcpy(slot->Data, data + EBYTE_ARQ_HEADER, slot->Len);
+			slot->Full = true;
+		}
+	}
+
+	// what arrived past a gap the sender gave up on goes out too
+	DeliverInOrder();
+
+	_ackPending = true;
+	_lastData = millis();
+}
+
+void EBYTE_E220_ARQ::DeliverInOrder() {
+
+	RxSlot *slot = &_rx[_rxNext % EBYTE_ARQ_WINDOW];
+
+	while (slot->Full) {
+		if (_handler) {
+			_handler(slot->Data, slot->Len, _ctx);
+		}
+		slot->Full = false;
+		_delivered++;
+		_rxNext++;
+		slot = &_rx[_rxNext % EBYTE_ARQ_WINDOW];
+	}
+}
+
+/*
+ack is the next sequence number expected (everything before it arrived) and a bitmap,
+bit i set means _rxNext + 1 + i arrived
+*/
+
+bool EBYTE_E220_ARQ::SendAck() {
+
+	uint32_t map = 0;
+	uint8_t ack[5];
+
+	for (uint8_t i = 0; i < EBYTE_ARQ_WINDOW - 1; i++) {
+		if (_rx[(uint8_t) (_rxNext + 1 + i) % EBYTE_ARQ_WINDOW].Full) {
+			map |= (1UL << i);
+		}
+	}
+
+	ack[0] = _rxNext;
+	ack[1] = map & 0xFF;
+	ack[2] = (map >> 8) & 0xFF;
+	ack[3] = (map >> 16) & 0xFF;
+	ack[4] = (map >> 24) & 0xFF;
+
+	SendFrame(EBYTE_FRAME_ARQ_ACK, ack, sizeof(ack));
+	_ackPending = false;
+
+	return true;
+}
+
+void EBYTE_E220_ARQ::GotAck(uint8_t *data, uint8_t len) {
+
+	if (len < 5) {
+		return;
+	}
+
+	uint8_t cum = data[0];
+	uint8_t outstanding = _txNext - _txBase;
+	uint32_t map = (uint32_t) data[1] | ((uint32_t) data[2] << 8) | ((uint32_t) data[3] << 16) | ((uint32_t) data[4] << 24);
+
+	// the receiver has moved past what we gave up on
+	if (_skipPending && (uint8_t) (cum - _skipTo) < 128) {
+		_skipPending = false;
+	}
+
+	// stale ack from before our window moved
+	if ((uint8_t) (cum - _txBase) > outstanding) {
+		return;
+	}
+
+	for (uint8_t seq = _txBase; seq != cum; seq++) {
+		_tx[seq % EBYTE_ARQ_WINDOW].Acked = true;
+	}
+
+	for (uint8_t i = 0; i < 32; i++) {
+		uint8_t seq = cum + 1 + i;
+		if ((map & (1UL << i)) && (uint8_t) (seq - _txBase) < outstanding) {
+			_tx[seq % EBYTE_ARQ_WINDOW].Acked = true;
+		}
+	}
+
+	Advance();
+}
+
+void EBYTE_E220_ARQ::Advance() {
+
+	while (_txBase != _txNext && _tx[_txBase % EBYTE_ARQ_WINDOW].Acked) {
+		_txBase++;
+	}
+}
+
+/*
+just the header, numbered one before the base so the receiver takes the base from it, keeps
+nothing and acks
+*/
+
+void EBYTE_E220_ARQ::SendBase() {
+
+	uint8_t header[EBYTE_ARQ_HEADER];
+
+	header[0] = _txBase - 1;
+	header[1] = _txBase;
+
+	SendFrame(EBYTE_FRAME_ARQ_DATA, header, sizeof(header));
+}
+
+void EBYTE_E220_ARQ::SendFrame(uint8_t type, const uint8_t *data, uint8_t len) {
+
+	if (_fixed) {
+		_radio->sendFrame(_address, _channel, type, data, len);
+	}
+	else {
+		_radio->sendFrame(type, data, len);
+	}
+}
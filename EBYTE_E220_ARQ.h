@@ -0,0 +1,180 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Reliable delivery for the EBYTE_E220 library
+
+  Selective repeat ARQ on top of sendFrame() and EBYTE_E220_Receiver. Each message gets a sequence
+  number, up to EBYTE_ARQ_WINDOW messages can be in the air before an acknowledgment comes back, and
+  only the messages that were actually lost are sent again. The receiver acknowledges with the next
+  sequence number it expects plus a bitmap of what it got past that, and hands messages to your
+  handler in the order they were sent. The module is half duplex, so the receiver waits for a gap in
+  the incoming data before it acknowledges--a sender with a full window goes quiet and gets its ack.
+
+  Timers come from the configured air data rate and packet size, so call updateTimers() after changing
+  those settings. Use the same object for both directions, both ends run the same code
+
+  EBYTE_E220_ARQ Link(&Transceiver, &Receiver);
+
+  Link.begin();
+  Link.onReceive(GotMessage, NULL);
+  ...
+  Link.send((uint8_t*) &MyData, sizeof(MyData));   // false if the window is full, try again later
+  ...
+  void loop() {
+    Receiver.service();
+    Link.service();
+  }
+
+  All buffers are static, RAM used is about 2 * EBYTE_ARQ_WINDOW * EBYTE_ARQ_PAYLOAD bytes
+*/
+
+#ifndef EBYTE_E220_ARQ_H_LIB
+#define EBYTE_E220_ARQ_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// messages in flight, a power of 2 no bigger than 32 (the size of the ack bitmap)
+#ifndef EBYTE_ARQ_WINDOW
+#define EBYTE_ARQ_WINDOW 8
+#endif
+
+// largest message
+#ifndef EBYTE_ARQ_PAYLOAD
+#define EBYTE_ARQ_PAYLOAD 48
+#endif
+
+// sends of one message before it's given up on
+#define EBYTE_ARQ_RETRIES 8
+
+// extra time allowed on top of the calculated air times (ms), covers UART and processing time
+#define EBYTE_ARQ_GUARD 50
+
+// seq + base in front of the payload
+#define EBYTE_ARQ_HEADER 2
+
+typedef void (*EBYTE_ARQHandler)(uint8_t *data, uint8_t len, void *ctx);
+
+class EBYTE_E220_ARQ {
+
+public:
+
+	EBYTE_E220_ARQ(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	// registers with the receiver (false if it has no room) and works out the timers from the radio settings
+	bool begin();
+
+	// work out the timers again after the air data rate or packet size changed
+	void updateTimers();
+
+	// send to one address with fixed point transmission (default is transparent)
+	void setPeer(uint16_t address, uint8_t channel);
+
+	void onReceive(EBYTE_ARQHandler handler, void *ctx);
+
+	// queue a message, false if the window is full or the message is too long
+	bool send(const uint8_t *data, uint8_t len);
+
+	// sends, resends and acknowledges, call often
+	void service();
+
+	// messages sent but not yet acknowledged
+	uint8_t pending();
+
+	// methods to get statistics
+	unsigned long getTimeout();
+	uint32_t getSent();
+	uint32_t getRetransmits();
+	uint32_t getDelivered();
+	uint32_t getDropped();
+	uint32_t getSkipped();
+
+private:
+
+	static void DataHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	static void AckHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+
+	void GotData(uint8_t *data, uint8_t len);
+	void GotAck(uint8_t *data, uint8_t len);
+	void Advance();
+	void DeliverInOrder();
+	void SendFrame(uint8_t type, const uint8_t *data, uint8_t len);
+	bool SendAck();
+	void SendBase();
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	EBYTE_ARQHandler _handler;
+	void *_ctx;
+
+	bool _fixed;
+	uint16_t _address;
+	uint8_t _channel;
+
+	unsigned long _timeout;
+	unsigned long _ackDelay;
+
+	// sender, slot is seq % EBYTE_ARQ_WINDOW
+	struct TxSlot {
+		uint8_t Data[EBYTE_ARQ_HEADER + EBYTE_ARQ_PAYLOAD];
+		uint8_t Len;
+		uint8_t Tries;
+		bool Acked;
+		unsigned long Sent;
+	};
+
+	TxSlot _tx[EBYTE_ARQ_WINDOW];
+	uint8_t _txBase;		// oldest message not acknowledged
+	uint8_t _txNext;		// sequence number for the next message
+
+	// a message was given up on, the base is sent on its own until the receiver acks past it
+	bool _skipPending;
+	uint8_t _skipTo;
+	uint8_t _skipTries;
+	unsigned long _skipSent;
+
+	// receiver
+	struct RxSlot {
+		uint8_t Data[EBYTE_ARQ_PAYLOAD];
+		uint8_t Len;
+		bool Full;
+	};
+
+	RxSlot _rx[EBYTE_ARQ_WINDOW];
+	uint8_t _rxNext;		// next sequence number to hand to the application
+	bool _ackPending;
+	unsigned long _lastData;
+
+	uint32_t _sent;
+	uint32_t _retransmits;
+	uint32_t _delivered;
+	uint32_t _dropped;
+	uint32_t _skipped;
+
+};
+
+#endif
@@ -0,0 +1,436 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Adapt.h>
+
+// first byte of every adaptation frame
+#define ADAPT_PROBE 1
+#define ADAPT_REPORT 2
+#define ADAPT_SWITCH 3
+#define ADAPT_SWITCH_ACK 4
+
+// op, seq and three argument bytes
+#define ADAPT_FRAME 5
+
+// extra time allowed for an answer on top of the air time there and back (ms)
+#define ADAPT_GUARD 200
+
+// most clean windows the step up wait backs off to
+#define ADAPT_MAX_HOLD 48
+
+EBYTE_E220_Adapt::EBYTE_E220_Adapt(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_ladder = NULL;
+	_steps = 0;
+	_controller = false;
+	_level = 0;
+	_good = 0;
+	_confirming = false;
+	_switchedAt = 0;
+	_heardAt = 0;
+	_noise = -999;
+	_noiseAt = 0;
+	_applyPending = false;
+	_applyLevel = 0;
+	_seq = 0;
+	_waiting = false;
+	_answered = false;
+	_switching = false;
+	_target = 0;
+	_tries = 0;
+	_sentAt = 0;
+	_probes = 0;
+	_replies = 0;
+	_marginSum = 0;
+	_marginCount = 0;
+	_clean = 0;
+	_hold = EBYTE_ADAPT_HOLD;
+	_margin = -999;
+	_loss = 0;
+	_switches = 0;
+	_reverts = 0;
+
+	memset(_default, 0, sizeof(_default));
+}
+
+void EBYTE_E220_Adapt::setLadder(const EBYTE_AdaptStep *steps, uint8_t count) {
+	_ladder = steps;
+	_steps = min(count, (uint8_t) EBYTE_ADAPT_STEPS);
+}
+
+/*
+build the default ladder if none was given and find the step the module is on now,
+if it isn't on any step go to step 0 (the other end does the same)
+*/
+
+bool EBYTE_E220_Adapt::begin(bool controller) {
+
+	uint8_t adr = _radio->getAirDataRate();
+	uint8_t power = _radio->getTransmitPower();
+
+	_controller = controller;
+
+	if (!_ladder) {
+		_steps = 0;
+		if (power != 0) {
+			_default[_steps].AirDataRate = ADR_2400;
+			_default[_steps].Power = 0;
+			_default[_steps].Margin = EBYTE_ADAPT_MARGIN;
+			_steps++;
+		}
+		for (uint8_t rate = ADR_2400; rate <= ADR_62500 && _steps < EBYTE_ADAPT_STEPS; rate++) {
+			_default[_steps].AirDataRate = rate;
+			_default[_steps].Power = power;
+			_default[_steps].Margin = EBYTE_ADAPT_MARGIN + ((rate - ADR_2400) * EBYTE_ADAPT_RATE_STEP);
+			_steps++;
+		}
+		_ladder = _default;
+	}
+
+	_level = 0;
+	for (uint8_t i = 0; i < _steps; i++) {
+		if (_ladder[i].AirDataRate == adr && _ladder[i].Power == power) {
+			_level = i;
+			break;
+		}
+	}
+	Apply(_ladder[_level].AirDataRate, _ladder[_level].Power);
+
+	_good = _level;
+	_heardAt = millis();
+
+	return _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_ADAPT);
+}
+
+void EBYTE_E220_Adapt::service() {
+
+	unsigned long now = millis();
+
+	if (_controller) {
+		Controller(now);
+	}
+	else {
+		Follower(now);
+	}
+}
+
+uint8_t EBYTE_E220_Adapt::getLevel() {
+	return _level;
+}
+
+int16_t EBYTE_E220_Adapt::getMargin() {
+	return _margin;
+}
+
+uint8_t EBYTE_E220_Adapt::getLoss() {
+	return _loss;
+}
+
+uint32_t EBYTE_E220_Adapt::getSwitches() {
+	return _switches;
+}
+
+uint32_t EBYTE_E220_Adapt::getReverts() {
+	return _reverts;
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_Adapt::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t rssi, void *ctx) {
+	((EBYTE_E220_Adapt*) ctx)->GotFrame(data, len, rssi);
+}
+
+/*
+register writes are done from service() and not from here, the write changes mode and
+that drains the receiver we were called from
+*/
+
+void EBYTE_E220_Adapt::GotFrame(uint8_t *data, uint8_t len, int16_t rssi) {
+
+	if (len < ADAPT_FRAME) {
+		return;
+	}
+
+	uint8_t op = data[0];
+	uint8_t seq = data[1];
+
+	if (!_controller) {
+
+		_heardAt = millis();
+
+		if (op == ADAPT_PROBE) {
+			if (_confirming && data[2] == _level) {
+				_good = _level;
+				_confirming = false;
+			}
+			// RSSI and noise go as the module reports them (dBm + 256), 0 if we don't have them
+			Send(ADAPT_REPORT, seq, (rssi == -999) ? 0 : (uint8_t) (256 + rssi), (_noise == -999) ? 0 : (uint8_t) (256 + _noise), _level);
+		}
+		else if (op == ADAPT_SWITCH && data[2] < _steps) {
+			Send(ADAPT_SWITCH_ACK, seq, data[2], 0, 0);
+			_applyLevel = data[2];
+			_applyPending = true;
+		}
+		return;
+	}
+
+	if (!_waiting || _answered || seq != _seq) {
+		return;
+	}
+
+	if (_switching) {
+		if (op == ADAPT_SWITCH_ACK && data[2] == _target) {
+			_answered = true;
+			_heardAt = millis();
+		}
+		return;
+	}
+
+	if (op != ADAPT_REPORT) {
+		return;
+	}
+
+	_answered = true;
+	_heardAt = millis();
+
+	if (_confirming) {
+		_good = _level;
+		_confirming = false;
+		_hold = EBYTE_ADAPT_HOLD;
+	}
+
+	// margin is the worse of the two directions we can see
+	int16_t margin = 32767;
+
+	if (data[2] && data[3]) {
+		margin = (int16_t) data[2] - (int16_t) data[3];
+	}
+	if (rssi != -999 && _noise != -999) {
+		margin = min(margin, (int16_t) (rssi - _noise));
+	}
+	if (margin != 32767) {
+		_marginSum += margin;
+		_marginCount++;
+	}
+}
+
+void EBYTE_E220_Adapt::Follower(unsigned long now) {
+
+	if (_applyPending) {
+		// let the ack get out on the old settings first
+		if (_radio->getAux()) {
+			_applyPending = false;
+			if (_applyLevel != _level) {
+				Apply(_ladder[_applyLevel].AirDataRate, _ladder[_applyLevel].Power);
+				_level = _applyLevel;
+				_confirming = true;
+				_switchedAt = millis();
+			}
+		}
+		return;
+	}
+
+	if (_confirming && (now - _switchedAt) >= EBYTE_ADAPT_REVERT) {
+		// the controller can't reach us on the new step
+		Apply(_ladder[_good].AirDataRate, _ladder[_good].Power);
+		_level = _good;
+		_confirming = false;
+		_reverts++;
+		_heardAt = millis();
+		return;
+	}
+
+	if (_level != 0 && (now - _heardAt) >= EBYTE_ADAPT_LOST) {
+		Apply(_ladder[0].AirDataRate, _ladder[0].Power);
+		_level = 0;
+		_good = 0;
+		_confirming = false;
+		_heardAt = millis();
+		return;
+	}
+
+	// keep a recent noise reading for the reports, the answer comes back on the same port as
+	// the frames so only ask while nothing is arriving
+	if ((now - _noiseAt) >= EBYTE_ADAPT_INTERVAL && _radio->getAux() && _receiver->idle()) {
+		_noise = _radio->readRSSIAmbientNoise();
+		_noiseAt = millis();
+	}
+}
+
+void EBYTE_E220_Adapt::Controller(unsigned long now) {
+
+	unsigned long timeout = (2 * _radio->getAirTime(EBYTE_FRAME_OVERHEAD + ADAPT_FRAME) / 1000) + ADAPT_GUARD;
+
+	if (!_radio->getAux()) {
+		return;
+	}
+
+	if (_switching) {
+		if (_answered) {
+			Apply(_ladder[_target].AirDataRate, _ladder[_target].Power);
+			_level = _target;
+			_confirming = true;
+			_switchedAt = millis();
+			_switching = false;
+			_waiting = false;
+			_switches++;
+		}
+		else if (!_waiting || (now - _sentAt) >= timeout) {
+			if (_tries >= EBYTE_ADAPT_RETRIES) {
+				// if the follower switched and lost its ack it comes back by itself
+				_switching = false;
+				_waiting = false;
+				return;
+			}
+			_tries++;
+			_seq++;
+			_waiting = true;
+			_answered = false;
+			_sentAt = now;
+			Send(ADAPT_SWITCH, _seq, _target, 0, 0);
+		}
+		return;
+	}
+
+	if (_confirming && (now - _switchedAt) >= EBYTE_ADAPT_REVERT) {
+		Apply(_ladder[_good].AirDataRate, _ladder[_good].Power);
+		_level = _good;
+		_confirming = false;
+		_reverts++;
+		_hold = min((uint8_t) (_hold * 2), (uint8_t) ADAPT_MAX_HOLD);
+		_heardAt = millis();
+		_probes = _replies = _marginCount = 0;
+		_marginSum = 0;
+		return;
+	}
+
+	if (!_confirming && _level != 0 && (now - _heardAt) >= EBYTE_ADAPT_LOST) {
+		Apply(_ladder[0].AirDataRate, _ladder[0].Power);
+		_level = 0;
+		_good = 0;
+		_heardAt = millis();
+		_probes = _replies = _marginCount = 0;
+		_marginSum = 0;
+		return;
+	}
+
+	if (_waiting) {
+		if (!_answered && (now - _sentAt) < timeout) {
+			return;
+		}
+		_waiting = false;
+		_probes++;
+		if (_answered) {
+			_replies++;
+		}
+		if (_probes >= EBYTE_ADAPT_WINDOW) {
+			Decide();
+		}
+		return;
+	}
+
+	if ((now - _sentAt) < EBYTE_ADAPT_INTERVAL) {
+		return;
+	}
+
+	// a window without a fresh reading keeps the last one
+	if (_probes == 0 && _radio->getAux() && _receiver->idle()) {
+		_noise = _radio->readRSSIAmbientNoise();
+	}
+
+	_seq++;
+	_waiting = true;
+	_answered = false;
+	_sentAt = millis();
+	Send(ADAPT_PROBE, _seq, _level, 0, 0);
+}
+
+/*
+end of a window, step down on loss or low margin, step up only after _hold clean windows
+with room to spare on the next step
+*/
+
+void EBYTE_E220_Adapt::Decide() {
+
+	bool known;
+
+	_loss = (uint8_t) ((100 * (_probes - _replies)) / _probes);
+	_margin = _marginCount ? (int16_t) (_marginSum / _marginCount) : -999;
+	_probes = _replies = _marginCount = 0;
+	_marginSum = 0;
+
+	known = (_margin != -999);
+
+	if (_confirming) {
+		return;
+	}
+
+	if (_level > 0 && (_loss > EBYTE_ADAPT_LOSS || (known && _margin < _ladder[_level].Margin))) {
+		_clean = 0;
+		_target = _level - 1;
+	}
+	else if (_loss == 0 && _level + 1 < _steps && (!known || Predict(_level + 1) >= _ladder[_level + 1].Margin + EBYTE_ADAPT_HYSTERESIS)) {
+		if (++_clean < _hold) {
+			return;
+		}
+		_clean = 0;
+		_target = _level + 1;
+	}
+	else {
+		_clean = 0;
+		return;
+	}
+
+	_switching = true;
+	_waiting = false;
+	_answered = false;
+	_tries = 0;
+}
+
+// margin we'd expect on another step, only the power changes what we hear
+
+int16_t EBYTE_E220_Adapt::Predict(uint8_t level) {
+	return _margin + (((int16_t) _ladder[_level].Power - (int16_t) _ladder[level].Power) * EBYTE_ADAPT_POWER_STEP);
+}
+
+void EBYTE_E220_Adapt::Send(uint8_t op, uint8_t seq, uint8_t a, uint8_t b, uint8_t c) {
+
+	uint8_t buf[ADAPT_FRAME] = {op, seq, a, b, c};
+
+	_radio->sendFrame(EBYTE_FRAME_ADAPT, buf, sizeof(buf));
+}
+
+/*
+temporary write of REG0 (air data rate) and REG1 (power) so a power cycle brings back the saved settings
+*/
+
+void EBYTE_E220_Adapt::Apply(uint8_t adr, uint8_t power) {
+
+	if (adr == _radio->getAirDataRate() && power == _radio->getTransmitPower()) {
+		return;
+	}
+
+	_radio->setAirDataRate(adr);
+	_radio->setTransmitPower(power);
+	_radio->saveRegisters(2, 2, EBYTE_WRITE_TEMPORARY);
+}
@@ -0,0 +1,184 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Link adaptation for the EBYTE_E220 library
+
+  Picks the air data rate (and transmit power) from how the link is doing instead of leaving
+  whatever saveParameters() set. One end is the controller, the other the follower.
+  The controller probes the follower every EBYTE_ADAPT_INTERVAL ms and the follower answers with the
+  RSSI it heard the probe at and its ambient noise, so the controller knows the margin (RSSI above
+  noise) both ways and the loss. Every EBYTE_ADAPT_WINDOW probes it decides
+  - step down (more robust) right away if loss is over EBYTE_ADAPT_LOSS or the margin is below what
+    the current step needs
+  - step up (faster) only after EBYTE_ADAPT_HOLD clean windows with the margin the next step needs
+    plus EBYTE_ADAPT_HYSTERESIS
+  A step change is a handshake, the controller asks, the follower acks on the old settings and
+  both switch with a temporary register write. If the new settings don't carry traffic within
+  EBYTE_ADAPT_REVERT ms both ends go back to the last settings that did (and the controller waits
+  twice as long before trying that step again). After EBYTE_ADAPT_LOST ms with nothing heard both
+  ends go to step 0 and meet there.
+
+  The default ladder, most robust first, is 2400 baud at full power, then every rate from 2400 to
+  62500 at the power the module was set to. Both ends must start on the same settings.
+
+  EBYTE_E220_Adapt Adapt(&Transceiver, &Receiver);
+
+  Transceiver.setRSSISignalStrength(true);		// optional but the margin needs them
+  Transceiver.setRSSIAmbientNoise(true);
+  Transceiver.saveParameters(EBYTE_WRITE_TEMPORARY);
+  Receiver.setRSSI(true);
+  Adapt.begin(true);							// false on the other end
+  ...
+  void loop() {
+    Receiver.service();
+    Adapt.service();
+  }
+
+  Without RSSI the decision is made on loss alone
+*/
+
+#ifndef EBYTE_E220_ADAPT_H_LIB
+#define EBYTE_E220_ADAPT_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// ms between probes
+#ifndef EBYTE_ADAPT_INTERVAL
+#define EBYTE_ADAPT_INTERVAL 1000
+#endif
+
+// probes per decision
+#define EBYTE_ADAPT_WINDOW 4
+
+// loss (percent) over a window that forces a step down
+#define EBYTE_ADAPT_LOSS 25
+
+// margin (dB above noise) the slowest rate needs, each faster rate needs EBYTE_ADAPT_RATE_STEP more
+#define EBYTE_ADAPT_MARGIN 10
+#define EBYTE_ADAPT_RATE_STEP 3
+
+// dB gained by each transmit power step (TRP_xx codes are 3 to 5 dB apart, this is the low end)
+#define EBYTE_ADAPT_POWER_STEP 3
+
+// extra margin (dB) needed before stepping up, so we don't flap between two steps
+#define EBYTE_ADAPT_HYSTERESIS 6
+
+// clean windows before stepping up
+#define EBYTE_ADAPT_HOLD 3
+
+// ms on new settings with nothing heard before going back to the last ones that worked
+#define EBYTE_ADAPT_REVERT (5 * EBYTE_ADAPT_INTERVAL)
+
+// ms with nothing heard before both ends go to step 0
+#define EBYTE_ADAPT_LOST (3 * EBYTE_ADAPT_REVERT)
+
+// times a switch request is sent before giving up
+#define EBYTE_ADAPT_RETRIES 3
+
+// most steps in a ladder
+#define EBYTE_ADAPT_STEPS 8
+
+struct EBYTE_AdaptStep {
+	uint8_t AirDataRate;		// ADR_xxx
+	uint8_t Power;				// TRP_xx
+	int8_t Margin;				// dB above noise this step needs
+};
+
+class EBYTE_E220_Adapt {
+
+public:
+
+	EBYTE_E220_Adapt(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	// optional, before begin(), most robust step first (the array must stay valid)
+	void setLadder(const EBYTE_AdaptStep *steps, uint8_t count);
+
+	bool begin(bool controller);
+
+	// call often (after Receiver.service())
+	void service();
+
+	uint8_t getLevel();
+	int16_t getMargin();		// last window, -999 if unknown
+	uint8_t getLoss();			// last window, percent
+	uint32_t getSwitches();
+	uint32_t getReverts();
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotFrame(uint8_t *data, uint8_t len, int16_t rssi);
+	void Controller(unsigned long now);
+	void Follower(unsigned long now);
+	void Decide();
+	void Send(uint8_t op, uint8_t seq, uint8_t a, uint8_t b, uint8_t c);
+	void Apply(uint8_t adr, uint8_t power);
+	int16_t Predict(uint8_t level);
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	EBYTE_AdaptStep _default[EBYTE_ADAPT_STEPS];
+	const EBYTE_AdaptStep *_ladder;
+	uint8_t _steps;
+
+	bool _controller;
+	uint8_t _level;
+	uint8_t _good;					// last step that carried traffic
+	bool _confirming;				// switched, waiting to hear something on the new step
+	unsigned long _switchedAt;
+	unsigned long _heardAt;
+	int16_t _noise;
+	unsigned long _noiseAt;
+
+	// follower, switch waiting for its ack to go out
+	bool _applyPending;
+	uint8_t _applyLevel;
+
+	// controller
+	uint8_t _seq;
+	bool _waiting;
+	bool _answered;
+	bool _switching;
+	uint8_t _target;
+	uint8_t _tries;
+	unsigned long _sentAt;
+	uint8_t _probes;
+	uint8_t _replies;
+	int32_t _marginSum;
+	uint8_t _marginCount;
+	uint8_t _clean;
+	uint8_t _hold;
+
+	int16_t _margin;
+	uint8_t _loss;
+	uint32_t _switches;
+	uint32_t _reverts;
+
+};
+
+#endif
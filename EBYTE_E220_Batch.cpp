@@ -0,0 +1,215 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Batch.h>
+
+EBYTE_E220_Batcher::EBYTE_E220_Batcher(EBYTE_E220 *radio) {
+
+	_radio = radio;
+	_len = 0;
+	_count = 0;
+	_first = 0;
+	_maxDelay = EBYTE_BATCH_DELAY;
+	_threshold = 0;
+	_fixed = false;
+	_address = 0;
+	_channel = 0;
+	_records = 0;
+	_frames = 0;
+}
+
+void EBYTE_E220_Batcher::setTarget(uint16_t address, uint8_t channel) {
+
+	_fixed = true;
+	_address = address;
+	_channel = channel;
+}
+
+void EBYTE_E220_Batcher::setMaxDelay(unsigned long ms) {
+	_maxDelay = ms;
+}
+
+void EBYTE_E220_Batcher::setThreshold(uint8_t bytes) {
+	_threshold = bytes;
+}
+
+/*
+method to get how much a batch can hold, one sub packet less the frame's own bytes so each
+batch goes on air as one packet
+*/
+
+uint8_t EBYTE_E220_Batcher::Capacity() {
+
+	uint8_t cap = _radio->getPacketBytes() - EBYTE_FRAME_OVERHEAD;
+
+	return cap > EBYTE_FRAME_MAX ? EBYTE_FRAME_MAX : cap;
+}
+
+bool EBYTE_E220_Batcher::write(uint8_t type, const uint8_t *data, uint8_t len) {
+
+	uint8_t cap = Capacity();
+	uint16_t need = EBYTE_BATCH_RECORD + len;
+
+	// can't share a sub packet, keep the order and send it on its own
+	if (need > cap) {
+		flush();
+		return Send(type, data, len);
+	}
+
+	if (_len + need > cap) {
+		// the last batch is still going out, more would only pile up in the module
+		if (!_radio->getAux()) {
+			return false;
+		}
+		flush();
+	}
+
+	if (_count == 0) {
+		_first = millis();
+	}
+
+	_buf[_len] = type;
+	_buf[_len + 1] = len;
+	memcpy(&_buf[_len + EBYTE_BATCH_RECORD], data, len);
+	_len += need;
+	_count++;
+	_records++;
+
+	service();
+
+	return true;
+}
+
+/*
+method to send the batch when it's full or its oldest record has waited long enough, and the
+module has finished with the last one
+*/
+
+void EBYTE_E220_Batcher::service() {
+
+	if (_count == 0 || !_radio->getAux()) {
+		return;
+	}
+
+	uint8_t cap = Capacity();
+	uint8_t limit = (_threshold && _threshold < cap) ? _threshold : cap;
+
+	if (_len >= limit || (millis() - _first) >= _maxDelay) {
+		flush();
+	}
+}
+
+bool EBYTE_E220_Batcher::flush() {
+
+	bool ok;
+
+	if (_count == 0) {
+		return true;
+	}
+
+	// one record needs no batch around it
+	if (_count == 1) {
+		ok = Send(_buf[0], &_buf[EBYTE_BATCH_RECORD], _buf[1]);
+	}
+	else {
+		ok = Send(EBYTE_FRAME_BATCH, _buf, _len);
+	}
+
+	_len = 0;
+	_count = 0;
+
+	return ok;
+}
+
+bool EBYTE_E220_Batcher::Send(uint8_t type, const uint8_t *data, uint8_t len) {
+
+	_frames++;
+
+	if (_fixed) {
+		return _radio->sendFrame(_address, _channel, type, data, len);
+	}
+
+	return _radio->sendFrame(type, data, len);
+}
+
+uint8_t EBYTE_E220_Batcher::pending() {
+	return _len;
+}
+
+uint32_t EBYTE_E220_Batcher::getRecords() {
+	return _records;
+}
+
+uint32_t EBYTE_E220_Batcher::getFrames() {
+	return _frames;
+}
+
+EBYTE_E220_Unbatcher::EBYTE_E220_Unbatcher(EBYTE_E220_Receiver *receiver) {
+
+	_receiver = receiver;
+	_records = 0;
+	_errors = 0;
+}
+
+bool EBYTE_E220_Unbatcher::begin() {
+
+	if (!_receiver->onFrame(FrameHandler, this, EBYTE_FRAME_BATCH)) {
+		return false;
+	}
+
+	// the records come through the handlers again, those that take everything only see them
+	_receiver->setContainer(EBYTE_FRAME_BATCH);
+
+	return true;
+}
+
+void EBYTE_E220_Unbatcher::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t rssi, void *ctx) {
+	((EBYTE_E220_Unbatcher *) ctx)->GotBatch(data, len, rssi);
+}
+
+/*
+method to hand each record to the handlers, the batch is checked first so a bad one is
+dropped whole rather than part delivered
+*/
+
+void EBYTE_E220_Unbatcher::GotBatch(uint8_t *data, uint8_t len, int16_t rssi) {
+
+	uint8_t pos = 0;
+
+	while (pos < len) {
+		if (pos + EBYTE_BATCH_RECORD > len || pos + EBYTE_BATCH_RECORD + data[pos + 1] > len || data[pos] == EBYTE_FRAME_BATCH) {
+			_errors++;
+			return;
+		}
+		pos += EBYTE_BATCH_RECORD + data[pos + 1];
+	}
+
+	for (pos = 0; pos < len; pos += EBYTE_BATCH_RECORD + data[pos + 1]) {
+		_records++;
+		_receiver->deliver(data[pos], &data[pos + EBYTE_BATCH_RECORD], data[pos + 1], rssi);
+	}
+}
+
+uint32_t EBYTE_E220_Unbatcher::getRecords() {
+	return _records;
+}
+
+uint32_t EBYTE_E220_Unbatcher::getErrors() {
+	return _errors;
+}
@@ -0,0 +1,146 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Small write coalescing for the EBYTE_E220 library
+
+  Every packet on air pays for a preamble and header, at 2400 bps that's worth more than a few
+  bytes of sensor data. A node that sends a few bytes at a time spends most of its air time on
+  overhead. EBYTE_E220_Batcher holds small records back and sends them together, as many as fit
+  in one sub packet (getPacketBytes()), like Nagle's algorithm does for TCP. A batch goes out when
+  it is full, or when its oldest record has waited the longest you allow (setMaxDelay()), and only
+  when the module is free so records keep piling in while the last batch is on air.
+
+  On the receiving end EBYTE_E220_Unbatcher takes the records out and hands each to the receiver's
+  handlers as if it had come in its own frame, so the handlers don't change. EBYTE_FRAME_ANY
+  handlers (EBYTE_E220_RxLog for one) see the records and not the batch frame they came in,
+  begin() tells the receiver so with setContainer().
+
+  A batch frame (EBYTE_FRAME_BATCH) holds records of type + length + data. A batch with one record
+  goes out as a plain frame of that record's type. Records too big to share a sub packet are sent
+  as they are, after what's held.
+
+  sender
+  EBYTE_E220_Batcher Batcher(&Transceiver);
+  Batcher.setMaxDelay(100);
+  ...
+  Batcher.write(EBYTE_FRAME_DATA, (uint8_t*) &Reading, sizeof(Reading));
+  ...
+  void loop() {
+	Batcher.service();
+  }
+
+  receiver
+  EBYTE_E220_Unbatcher Unbatcher(&Receiver);
+  Unbatcher.begin();
+*/
+
+#ifndef EBYTE_E220_BATCH_H_LIB
+#define EBYTE_E220_BATCH_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// default longest a record waits for others (ms)
+#define EBYTE_BATCH_DELAY 50
+
+// type and length in front of each record
+#define EBYTE_BATCH_RECORD 2
+
+class EBYTE_E220_Batcher {
+
+public:
+
+	EBYTE_E220_Batcher(EBYTE_E220 *radio);
+
+	// for fixed point transmission, all batches go to this address and channel
+	void setTarget(uint16_t address, uint8_t channel);
+
+	void setMaxDelay(unsigned long ms);
+
+	// send once this many bytes are held, 0 (default) fills the sub packet
+	void setThreshold(uint8_t bytes);
+
+	// false if the batch is full and the module is still sending the last one, the link can't
+	// keep up, write again later or drop the record
+	bool write(uint8_t type, const uint8_t *data, uint8_t len);
+
+	void service();
+
+	// send what's held now
+	bool flush();
+
+	uint8_t pending();			// bytes held
+	uint32_t getRecords();
+	uint32_t getFrames();		// frames sent, records / frames is what batching saved
+
+private:
+
+	uint8_t Capacity();
+	bool Send(uint8_t type, const uint8_t *data, uint8_t len);
+
+	EBYTE_E220 *_radio;
+
+	uint8_t _buf[EBYTE_FRAME_MAX];
+	uint8_t _len;
+	uint8_t _count;
+	unsigned long _first;
+
+	unsigned long _maxDelay;
+	uint8_t _threshold;
+
+	bool _fixed;
+	uint16_t _address;
+	uint8_t _channel;
+
+	uint32_t _records;
+	uint32_t _frames;
+
+};
+
+class EBYTE_E220_Unbatcher {
+
+public:
+
+	EBYTE_E220_Unbatcher(EBYTE_E220_Receiver *receiver);
+
+	bool begin();
+
+	uint32_t getRecords();
+	uint32_t getErrors();		// batches that didn't add up
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotBatch(uint8_t *data, uint8_t len, int16_t rssi);
+
+	EBYTE_E220_Receiver *_receiver;
+
+	uint32_t _records;
+	uint32_t _errors;
+
+};
+
+#endif
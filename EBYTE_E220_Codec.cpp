@@ -0,0 +1,248 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Codec.h>
+
+// first byte of a packed record, top bit marks a key record, the rest is a sequence number
+#define CODEC_KEY 0x80
+#define CODEC_SEQ 0x7F
+
+EBYTE_E220_Codec::EBYTE_E220_Codec(const EBYTE_Field *fields, uint8_t count) {
+
+	_fields = fields;
+	_count = min(count, (uint8_t) EBYTE_CODEC_FIELDS);
+	_interval = EBYTE_CODEC_KEY;
+	_raw = 0;
+	_packed = 0;
+
+	reset();
+}
+
+void EBYTE_E220_Codec::setKeyInterval(uint8_t interval) {
+	_interval = interval;
+}
+
+void EBYTE_E220_Codec::reset() {
+
+	_sinceKey = 0;
+	_seq = 0;
+	_valid = false;
+	memset(_prev, 0, sizeof(_prev));
+}
+
+/*
+pack a record
+*/
+
+uint8_t EBYTE_E220_Codec::encode(const void *record, uint8_t *out, uint8_t size) {
+
+	bool key = !_valid || _sinceKey >= _interval;
+	uint8_t len = 0;
+	uint8_t raw = 0;
+
+	if (size == 0) {
+		return 0;
+	}
+
+	out[len++] = (key ? CODEC_KEY : 0) | (_seq & CODEC_SEQ);
+
+	for (uint8_t i = 0; i < _count; i++) {
+
+		int32_t value = Get(record, i);
+		uint32_t delta = (uint32_t) value - (uint32_t) (key ? 0 : _prev[i]);
+
+		// zigzag, small changes either way become small numbers
+		uint32_t zz = (delta << 1) ^ (uint32_t) ((int32_t) delta >> 31);
+
+		// varint, 7 bits per byte, top bit says more follows
+		do {
+			if (len >= size) {
+				return 0;
+			}
+			uint8_t b = zz & 0x7F;
+			zz >>= 7;
+			out[len++] = zz ? (b | 0x80) : b;
+		} while (zz);
+
+		raw += FieldSize(i);
+	}
+
+	// only commit the new state once we know it fit
+	for (uint8_t i = 0; i < _count; i++) {
+		_prev[i] = Get(record, i);
+	}
+
+	_valid = true;
+	_sinceKey = key ? 1 : _sinceKey + 1;
+	_seq++;
+	_raw += raw;
+	_packed += len;
+
+	return len;
+}
+
+/*
+unpack a record
+*/
+
+bool EBYTE_E220_Codec::decode(const uint8_t *in, uint8_t len, void *record) {
+
+	uint8_t pos = 0;
+	int32_t values[EBYTE_CODEC_FIELDS];
+
+	if (len == 0) {
+		return false;
+	}
+
+	bool key = in[pos] & CODEC_KEY;
+	uint8_t seq = in[pos++] & CODEC_SEQ;
+
+	// a change record only makes sense on top of the record right before it
+	if (!key && (!_valid || seq != (uint8_t) ((_seq + 1) & CODEC_SEQ))) {
+		_valid = false;
+		return false;
+	}
+
+	for (uint8_t i = 0; i < _count; i++) {
+
+		uint32_t zz = 0;
+		uint8_t shift = 0;
+		uint8_t b;
+
+		do {
+			if (pos >= len || shift > 28) {
+				_valid = false;
+				return false;
+			}
+			b = in[pos++];
+			zz |= (uint32_t) (b & 0x7F) << shift;
+			shift += 7;
+		} while (b & 0x80);
+
+		uint32_t delta = (zz >> 1) ^ (uint32_t) -(int32_t) (zz & 1);
+		values[i] = (int32_t) (delta + (uint32_t) (key ? 0 : _prev[i]));
+	}
+
+	for (uint8_t i = 0; i < _count; i++) {
+		_prev[i] = values[i];
+		Set(record, i, values[i]);
+		_raw += FieldSize(i);
+	}
+
+	_seq = seq;
+	_valid = true;
+	_packed += len;
+
+	return true;
+}
+
+bool EBYTE_E220_Codec::send(EBYTE_E220 *radio, const void *record) {
+
+	uint8_t buf[EBYTE_FRAME_MAX];
+	uint8_t len = encode(record, buf, sizeof(buf));
+
+	if (len == 0) {
+		return false;
+	}
+
+	return radio->sendFrame(EBYTE_FRAME_PACKED, buf, len);
+}
+
+float EBYTE_E220_Codec::getRatio() {
+	return _packed ? (float) _raw / (float) _packed : 0.0f;
+}
+
+uint32_t EBYTE_E220_Codec::getRawBytes() {
+	return _raw;
+}
+
+uint32_t EBYTE_E220_Codec::getPackedBytes() {
+	return _packed;
+}
+
+/*
+private methods to move field values in and out of the record
+everything is carried as a 32 bit integer, floats either as their bits or quantized
+*/
+
+int32_t EBYTE_E220_Codec::Get(const void *record, uint8_t i) {
+
+	const uint8_t *p = (const uint8_t*) record + _fields[i].Offset;
+
+	switch (_fields[i].Type) {
+		case EBYTE_FIELD_U8: return *(const uint8_t*) p;
+		case EBYTE_FIELD_I8: return *(const int8_t*) p;
+		case EBYTE_FIELD_U16: { uint16_t v; memcpy(&v, p, 2); return v; }
+		case EBYTE_FIELD_I16: { int16_t v; memcpy(&v, p, 2); return v; }
+		case EBYTE_FIELD_FLOAT: {
+			float f;
+			memcpy(&f, p, 4);
+			if (_fields[i].Scale != 0.0f) {
+				return (int32_t) lround(f * _fields[i].Scale);
+			}
+			int32_t v;
+			memcpy(&v, &f, 4);
+			return v;
+		}
+		default: { int32_t v; memcpy(&v, p, 4); return v; }
+	}
+}
+
+void EBYTE_E220_Codec::Set(void *record, uint8_t i, int32_t value) {
+
+	uint8_t *p = (uint8_t*) record + _fields[i].Offset;
+
+	switch (_fields[i].Type) {
+		case EBYTE_FIELD_U8:
+		case EBYTE_FIELD_I8:
+			*p = (uint8_t) value;
+			break;
+		case EBYTE_FIELD_U16:
+		case EBYTE_FIELD_I16: {
+			uint16_t v = (uint16_t) value;
+			memcpy(p, &v, 2);
+			break;
+		}
+		case EBYTE_FIELD_FLOAT:
+			if (_fields[i].Scale != 0.0f) {
+				float f = (float) value / _fields[i].Scale;
+				memcpy(p, &f, 4);
+				break;
+			}
+			memcpy(p, &value, 4);
+			break;
+		default:
+			memcpy(p, &value, 4);
+			break;
+	}
+}
+
+uint8_t EBYTE_E220_Codec::FieldSize(uint8_t i) {
+
+	switch (_fields[i].Type) {
+		case EBYTE_FIELD_U8:
+		case EBYTE_FIELD_I8:
+			return 1;
+		case EBYTE_FIELD_U16:
+		case EBYTE_FIELD_I16:
+			return 2;
+		default:
+			return 4;
+	}
+}
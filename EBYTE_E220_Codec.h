@@ -0,0 +1,136 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Telemetry compression for the EBYTE_E220 library
+
+  Fewer bytes on air means shorter transmissions, more nodes per channel and less latency. The codec
+  packs a fixed layout record (your struct) field by field
+  1. each field is sent as the change from the previous record (delta encoding)
+  2. changes are zigzag encoded so small negative changes are small numbers
+  3. numbers are sent as varints, 7 bits per byte, so a field that didn't change costs 1 byte
+  4. floats can be quantized, a scale of 100 sends a float as an integer number of hundredths
+
+  Describe the struct once with EBYTE_FIELD() entries
+
+  struct DATA {
+    unsigned long Count;
+    int16_t Bits;
+    float Volts;
+  };
+
+  const EBYTE_Field Fields[] = {
+    EBYTE_FIELD(DATA, Count, EBYTE_FIELD_U32, 0),
+    EBYTE_FIELD(DATA, Bits, EBYTE_FIELD_I16, 0),
+    EBYTE_FIELD(DATA, Volts, EBYTE_FIELD_FLOAT, 100),   // 0.01 V resolution
+  };
+
+  EBYTE_E220_Codec Packer(Fields, 3);
+
+  sender:   Packer.send(&Transceiver, &MyData);
+  receiver: Unpacker.decode(data, len, &MyData) from an EBYTE_FRAME_PACKED frame handler
+
+  Every EBYTE_CODEC_KEY records a full record is sent. There's no way back to the sender, so a
+  receiver that sees a gap in the sequence numbers drops the changes until the next full record
+  and picks up again from there. No heap, RAM is 4 bytes per field
+*/
+
+#ifndef EBYTE_E220_CODEC_H_LIB
+#define EBYTE_E220_CODEC_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <stddef.h>
+#include "EBYTE_E220.h"
+
+// most fields in a record
+#ifndef EBYTE_CODEC_FIELDS
+#define EBYTE_CODEC_FIELDS 16
+#endif
+
+// default number of records between full (key) records
+#define EBYTE_CODEC_KEY 16
+
+// field types
+#define EBYTE_FIELD_U8 0
+#define EBYTE_FIELD_I8 1
+#define EBYTE_FIELD_U16 2
+#define EBYTE_FIELD_I16 3
+#define EBYTE_FIELD_U32 4
+#define EBYTE_FIELD_I32 5
+#define EBYTE_FIELD_FLOAT 6		// scale 0 sends all 32 bits, else value * scale rounded to an integer
+
+struct EBYTE_Field {
+	uint8_t Type;
+	uint8_t Offset;
+	float Scale;
+};
+
+#define EBYTE_FIELD(record, member, type, scale) { (type), (uint8_t) offsetof(record, member), (scale) }
+
+class EBYTE_E220_Codec {
+
+public:
+
+	EBYTE_E220_Codec(const EBYTE_Field *fields, uint8_t count);
+
+	void setKeyInterval(uint8_t interval);
+
+	// start over, the next record is sent in full
+	void reset();
+
+	// pack a record, returns the packed length (0 if it doesn't fit in size)
+	uint8_t encode(const void *record, uint8_t *out, uint8_t size);
+
+	// unpack a record, false if it's a change record and we missed the one before it
+	bool decode(const uint8_t *in, uint8_t len, void *record);
+
+	// pack and send as an EBYTE_FRAME_PACKED frame
+	bool send(EBYTE_E220 *radio, const void *record);
+
+	// methods to get statistics, ratio is raw bytes / packed bytes
+	float getRatio();
+	uint32_t getRawBytes();
+	uint32_t getPackedBytes();
+
+private:
+
+	int32_t Get(const void *record, uint8_t i);
+	void Set(void *record, uint8_t i, int32_t value);
+	uint8_t FieldSize(uint8_t i);
+
+	const EBYTE_Field *_fields;
+	uint8_t _count;
+	uint8_t _interval;
+	uint8_t _sinceKey;
+	uint8_t _seq;
+	bool _valid;
+
+	int32_t _prev[EBYTE_CODEC_FIELDS];
+
+	uint32_t _raw;
+	uint32_t _packed;
+
+};
+
+#endif
@@ -0,0 +1,460 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_FEC.h>
+
+// GF(256) tables, primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11D)
+// exp is doubled so log[a] + log[b] never needs a modulo
+
+static const uint8_t GF_Exp[512] PROGMEM = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26,
+	0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0,
+	0x9D, 0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+	0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1,
+	0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0,
+	0xFD, 0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+	0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE,
+	0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC,
+	0x85, 0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+	0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73,
+	0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF,
+	0xE3, 0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+	0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6,
+	0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09,
+	0x12, 0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+	0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01,
+	0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26, 0x4C,
+	0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D,
+	0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23, 0x46,
+	0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1, 0x5F,
+	0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD,
+	0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2, 0xD9,
+	0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE, 0x81,
+	0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85,
+	0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54, 0xA8,
+	0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73, 0xE6,
+	0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3,
+	0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41, 0x82,
+	0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6, 0x51,
+	0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12,
+	0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16, 0x2C,
+	0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01, 0x02
+};
+
+static const uint8_t GF_Log[256] PROGMEM = {
+	0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE, 0x1B, 0x68, 0xC7, 0x4B,
+	0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81, 0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71,
+	0x05, 0x8A, 0x65, 0x2F, 0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+	0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78, 0x4D, 0xE4, 0x72, 0xA6,
+	0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD, 0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88,
+	0x36, 0xD0, 0x94, 0xCE, 0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+	0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54, 0xFA, 0x85, 0xBA, 0x3D,
+	0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B, 0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57,
+	0x07, 0x70, 0xC0, 0xF7, 0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+	0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9, 0x23, 0x20, 0x89, 0x2E,
+	0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD, 0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61,
+	0xF2, 0x56, 0xD3, 0xAB, 0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+	0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC, 0x7F, 0x0C, 0x6F, 0xF6,
+	0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA, 0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A,
+	0xCB, 0x59, 0x5F, 0xB0, 0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+	0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA, 0xA8, 0x50, 0x58, 0xAF
+};
+
+static uint8_t GF_Mul(uint8_t a, uint8_t b) {
+
+	if (a == 0 || b == 0) {
+		return 0;
+	}
+	return pgm_read_byte(&GF_Exp[pgm_read_byte(&GF_Log[a]) + pgm_read_byte(&GF_Log[b])]);
+}
+
+static uint8_t GF_Div(uint8_t a, uint8_t b) {
+
+	if (a == 0 || b == 0) {
+		return 0;
+	}
+	return pgm_read_byte(&GF_Exp[pgm_read_byte(&GF_Log[a]) + 255 - pgm_read_byte(&GF_Log[b])]);
+}
+
+// alpha to the power e
+static uint8_t GF_Pow(uint16_t e) {
+	return pgm_read_byte(&GF_Exp[e % 255]);
+}
+
+// generator polynomial (x + 1)(x + a)...(x + a^(m-1)), Gen[i] is the coefficient of x^i
+// kept for the last m used as every column of a message uses the same one
+static uint8_t Gen[EBYTE_FEC_MAX_PARITY + 1];
+static uint8_t GenM = 0xFF;
+
+static void BuildGen(uint8_t m) {
+
+	if (m == GenM) {
+		return;
+	}
+
+	memset(Gen, 0, sizeof(Gen));
+	Gen[0] = 1;
+
+	for (uint8_t j = 0; j < m; j++) {
+		uint8_t root = GF_Pow(j);
+		for (uint8_t i = j + 1; i > 0; i--) {
+			Gen[i] = Gen[i - 1] ^ GF_Mul(Gen[i], root);
+		}
+		Gen[0] = GF_Mul(Gen[0], root);
+	}
+
+	GenM = m;
+}
+
+/*
+systematic encoder, the parity is the remainder of data(x) * x^m divided by the generator
+*/
+
+void EBYTE_E220_FEC::rsEncode(const uint8_t *data, uint8_t k, uint8_t *parity, uint8_t m, uint16_t stride) {
+
+	uint8_t reg[EBYTE_FEC_MAX_PARITY];
+
+	if (m == 0 || m > EBYTE_FEC_MAX_PARITY) {
+		return;
+	}
+
+	BuildGen(m);
+	memset(reg, 0, m);
+
+	for (uint8_t i = 0; i < k; i++) {
+		uint8_t fb = data[i * stride] ^ reg[0];
+		for (uint8_t j = 0; j < m - 1; j++) {
+			reg[j] = reg[j + 1] ^ GF_Mul(fb, Gen[m - 1 - j]);
+		}
+		reg[m - 1] = GF_Mul(fb, Gen[0]);
+	}
+
+	for (uint8_t j = 0; j < m; j++) {
+		parity[j * stride] = reg[j];
+	}
+}
+
+/*
+erasure decoder, we know which symbols are missing (chunks that never arrived) so up to m of them
+can be rebuilt. symbol at position p is the coefficient of x^(n - 1 - p)
+1. syndromes of the codeword with the erased symbols set to 0
+2. erasure locator from the known positions
+3. error evaluator and Forney's formula give the missing values
+*/
+
+bool EBYTE_E220_FEC::rsErasures(uint8_t *code, uint8_t n, uint8_t m, uint16_t stride, const uint8_t *erasures, uint8_t count) {
+
+	uint8_t syn[EBYTE_FEC_MAX_PARITY];
+	uint8_t lam[EBYTE_FEC_MAX_PARITY + 1];
+	uint8_t omega[EBYTE_FEC_MAX_PARITY];
+
+	if (count > m || m > EBYTE_FEC_MAX_PARITY) {
+		return false;
+	}
+	if (count == 0) {
+		return true;
+	}
+
+	for (uint8_t e = 0; e < count; e++) {
+		code[erasures[e] * stride] = 0;
+	}
+
+	for (uint8_t j = 0; j < m; j++) {
+		uint8_t root = GF_Pow(j);
+		uint8_t s = 0;
+		for (uint8_t p = 0; p < n; p++) {
+			s = GF_Mul(s, root) ^ code[p * stride];
+		}
+		syn[j] = s;
+	}
+
+	memset(lam, 0, sizeof(lam));
+	lam[0] = 1;
+	for (uint8_t e = 0; e < count; e++) {
+		uint8_t x = GF_Pow(n - 1 - erasures[e]);
+		for (uint8_t i = e + 1; i > 0; i--) {
+			lam[i] ^= GF_Mul(x, lam[i - 1]);
+		}
+	}
+
+	for (uint8_t i = 0; i < m; i++) {
+		omega[i] = 0;
+		for (uint8_t j = 0; j <= i && j <= count; j++) {
+			omega[i] ^= GF_Mul(syn[i - j], lam[j]);
+		}
+	}
+
+	for (uint8_t e = 0; e < count; e++) {
+
+		uint8_t x = GF_Pow(n - 1 - erasures[e]);
+		uint8_t xinv = GF_Div(1, x);
+		uint8_t num = 0;
+		uint8_t den = 0;
+		uint8_t pw = 1;
+
+		// omega(xinv)
+		for (uint8_t i = 0; i < m; i++) {
+			num ^= GF_Mul(omega[i], pw);
+			pw = GF_Mul(pw, xinv);
+		}
+
+		// lambda'(xinv), only the odd terms survive in GF(2^8)
+		pw = 1;
+		for (uint8_t i = 1; i <= count; i += 2) {
+			den ^= GF_Mul(lam[i], pw);
+			pw = GF_Mul(pw, GF_Mul(xinv, xinv));
+		}
+
+		if (den == 0) {
+			return false;
+		}
+
+		code[erasures[e] * stride] = GF_Mul(x, GF_Div(num, den));
+	}
+
+	return true;
+}
+
+/*
+message layer
+*/
+
+EBYTE_E220_FEC::EBYTE_E220_FEC(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_handler = NULL;
+	_ctx = NULL;
+	_chunk = EBYTE_PacketBytes(SUB_32BYTES) - EBYTE_FRAME_OVERHEAD - EBYTE_FEC_HEADER;
+	_txId = 0;
+	_txK = 0;
+	_txM = 0;
+	_txLen = 0;
+	_txNext = 0;
+	_sending = false;
+	_rxId = 0;
+	_rxK = 0;
+	_rxM = 0;
+	_rxLen = 0;
+	_rxChunk = 0;
+	_rxHave = 0;
+	_rxActive = false;
+	_rxDone = false;
+	_rxTime = 0;
+	_delivered = 0;
+	_recovered = 0;
+	_failed = 0;
+
+	memset(_percent, 0, sizeof(_percent));
+}
+
+/*
+a chunk plus its headers fills exactly one sub packet, so a lost sub packet is exactly one lost chunk
+*/
+
+bool EBYTE_E220_FEC::begin() {
+
+	_chunk = _radio->getPacketBytes() - EBYTE_FRAME_OVERHEAD - EBYTE_FEC_HEADER;
+	return _receiver->onFrame(ChunkHandler, this, EBYTE_FRAME_FEC);
+}
+
+void EBYTE_E220_FEC::setClass(uint8_t cls, uint8_t percent) {
+
+	if (cls < EBYTE_FEC_CLASSES) {
+		_percent[cls] = percent;
+	}
+}
+
+void EBYTE_E220_FEC::onReceive(EBYTE_FECHandler handler, void *ctx) {
+	_handler = handler;
+	_ctx = ctx;
+}
+
+bool EBYTE_E220_FEC::send(uint8_t cls, const uint8_t *data, uint8_t len) {
+
+	if (_sending || cls >= EBYTE_FEC_CLASSES || len == 0) {
+		return false;
+	}
+
+	uint8_t k = (len + _chunk - 1) / _chunk;
+	uint8_t m = ((uint16_t) k * _percent[cls] + 99) / 100;
+
+	if (m > EBYTE_FEC_MAX_PARITY || (k + m) > EBYTE_FEC_MAX_CHUNKS || (uint16_t) (k + m) * _chunk > EBYTE_FEC_BUFFER) {
+		return false;
+	}
+
+	memset(_tx, 0, (uint16_t) k * _chunk);
+	memcpy(_tx, data, len);
+
+	// one codeword per byte column
+	for (uint8_t i = 0; i < _chunk; i++) {
+		rsEncode(_tx + i, k, _tx + (uint16_t) k * _chunk + i, m, _chunk);
+	}
+
+	_txId++;
+	_txK = k;
+	_txM = m;
+	_txLen = len;
+	_txNext = 0;
+	_sending = true;
+
+	return true;
+}
+
+bool EBYTE_E220_FEC::busy() {
+	return _sending;
+}
+
+void EBYTE_E220_FEC::service() {
+
+	if (_rxActive && !_rxDone && (millis() - _rxTime) > EBYTE_FEC_TIMEOUT) {
+		Finish();
+	}
+
+	// one chunk at a time and only when the module is idle so its buffer never overflows
+	if (!_sending || !_radio->getAux()) {
+		return;
+	}
+
+	uint8_t frame[EBYTE_FRAME_MAX];
+
+	frame[0] = _txId;
+	frame[1] = _txNext;
+	frame[2] = _txK;
+	frame[3] = _txM;
+	frame[4] = _txLen;
+	memcpy(frame + EBYTE_FEC_HEADER, _tx + (uint16_t) _txNext * _chunk, _chunk);
+
+	_radio->sendFrame(EBYTE_FRAME_FEC, frame, EBYTE_FEC_HEADER + _chunk);
+
+	if (++_txNext >= _txK + _txM) {
+		_sending = false;
+	}
+}
+
+uint8_t EBYTE_E220_FEC::getChunkSize() {
+	return _chunk;
+}
+
+uint32_t EBYTE_E220_FEC::getDelivered() {
+	return _delivered;
+}
+
+uint32_t EBYTE_E220_FEC::getRecovered() {
+	return _recovered;
+}
+
+uint32_t EBYTE_E220_FEC::getFailed() {
+	return _failed;
+}
+
+void EBYTE_E220_FEC::ChunkHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_FEC*) ctx)->GotChunk(data, len);
+}
+
+void EBYTE_E220_FEC::GotChunk(uint8_t *data, uint8_t len) {
+
+	if (len <= EBYTE_FEC_HEADER) {
+		return;
+	}
+
+	uint8_t id = data[0];
+	uint8_t index = data[1];
+	uint8_t k = data[2];
+	uint8_t m = data[3];
+	uint8_t chunk = len - EBYTE_FEC_HEADER;
+
+	// first chunk of a new message, whatever we had of the last one is all we'll get
+	if (!_rxActive || id != _rxId) {
+		if (_rxActive && !_rxDone) {
+			Finish();
+		}
+		if (k == 0 || m > EBYTE_FEC_MAX_PARITY || (k + m) > EBYTE_FEC_MAX_CHUNKS || (uint16_t) (k + m) * chunk > EBYTE_FEC_BUFFER) {
+			return;
+		}
+		_rxId = id;
+		_rxK = k;
+		_rxM = m;
+		_rxLen = data[4];
+		_rxChunk = chunk;
+		_rxHave = 0;
+		_rxActive = true;
+		_rxDone = false;
+	}
+
+	if (_rxDone || index >= _rxK + _rxM || chunk != _rxChunk) {
+		return;
+	}
+
+	memcpy(_rx + (uint16_t) index * _rxChunk, data + EBYTE_FEC_HEADER, _rxChunk);
+	_rxHave |= (1UL << index);
+	_rxTime = millis();
+
+	// any k chunks will do, no need to wait for the rest
+	uint8_t have = 0;
+	for (uint8_t i = 0; i < _rxK + _rxM; i++) {
+		if (_rxHave & (1UL << i)) {
+			have++;
+		}
+	}
+	if (have >= _rxK) {
+		Finish();
+	}
+}
+
+/*
+rebuild any missing data chunks and hand the message over, or count it as failed
+*/
+
+void EBYTE_E220_FEC::Finish() {
+
+	uint8_t erasures[EBYTE_FEC_MAX_PARITY];
+	uint8_t count = 0;
+	bool lostData = false;
+
+	_rxDone = true;
+
+	for (uint8_t i = 0; i < _rxK + _rxM; i++) {
+		if (!(_rxHave & (1UL << i))) {
+			if (count >= _rxM) {
+				_failed++;
+				return;
+			}
+			erasures[count++] = i;
+			if (i < _rxK) {
+				lostData = true;
+			}
+		}
+	}
+
+	if (lostData) {
+		for (uint8_t i = 0; i < _rxChunk; i++) {
+			if (!rsErasures(_rx + i, _rxK + _rxM, _rxM, _rxChunk, erasures, count)) {
+				_failed++;
+				return;
+			}
+		}
+		_recovered++;
+	}
+
+	_delivered++;
+	if (_handler) {
+		_handler(_rx, _rxLen, _ctx);
+	}
+}
@@ -0,0 +1,165 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Forward error correction for the EBYTE_E220 library
+
+  The module drops any packet that fails its own CRC, so on a marginal link data isn't corrupted,
+  it's gone. This layer cuts a message into chunks that exactly fill one sub packet and adds parity
+  chunks made with a Reed-Solomon code run down each column of bytes, so byte i of every chunk forms
+  one codeword (the codewords are interleaved across the sub packet). Any k of the k + m chunks are
+  enough to rebuild the message, the receiver doesn't have to ask for anything again.
+
+  Overhead is set per message class as a percentage, rounded up to whole chunks
+
+  EBYTE_E220_FEC Fec(&Transceiver, &Receiver);
+
+  Fec.begin();							// after the packet size is set
+  Fec.setClass(0, 0);					// class 0, no parity (bulk logs)
+  Fec.setClass(1, 50);					// class 1, one parity chunk for every two data chunks
+  Fec.onReceive(GotMessage, NULL);
+  ...
+  Fec.send(1, (uint8_t*) &LapData, sizeof(LapData));
+  ...
+  void loop() {
+    Receiver.service();
+    Fec.service();
+  }
+
+  The Galois field tables live in flash (768 bytes), encode and decode are table lookups only
+*/
+
+#ifndef EBYTE_E220_FEC_H_LIB
+#define EBYTE_E220_FEC_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// number of message classes
+#ifndef EBYTE_FEC_CLASSES
+#define EBYTE_FEC_CLASSES 4
+#endif
+
+// bytes of chunks (data + parity) buffered for one message, one buffer to send and one to receive.
+// send() refuses a message whose chunks don't fit, on AVR that's 4 chunks of a 64 byte sub packet
+// (up to 165 bytes with one parity chunk) or 2 of a 128 byte one, so use small sub packets there
+#ifndef EBYTE_FEC_BUFFER
+#if defined(__AVR__)
+#define EBYTE_FEC_BUFFER 256
+#else
+#define EBYTE_FEC_BUFFER 512
+#endif
+#endif
+
+// most parity chunks per message
+#define EBYTE_FEC_MAX_PARITY 16
+
+// most chunks (data + parity) per message
+#define EBYTE_FEC_MAX_CHUNKS 32
+
+// chunk header, message id + index + data chunks + parity chunks + message length
+#define EBYTE_FEC_HEADER 5
+
+// a message still missing chunks after this long (ms) is given up on
+#define EBYTE_FEC_TIMEOUT 5000
+
+typedef void (*EBYTE_FECHandler)(uint8_t *data, uint8_t len, void *ctx);
+
+class EBYTE_E220_FEC {
+
+public:
+
+	EBYTE_E220_FEC(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	// registers with the receiver (false if it has no room) and sizes chunks to the current sub packet size
+	bool begin();
+
+	// parity as a percentage of the data for a message class
+	void setClass(uint8_t cls, uint8_t percent);
+
+	void onReceive(EBYTE_FECHandler handler, void *ctx);
+
+	// queue a message, false if the last one is still going out or it doesn't fit
+	bool send(uint8_t cls, const uint8_t *data, uint8_t len);
+	bool busy();
+
+	// sends chunks while the module is idle and drops stale partial messages, call often
+	void service();
+
+	// methods to get statistics
+	uint8_t getChunkSize();
+	uint32_t getDelivered();
+	uint32_t getRecovered();
+	uint32_t getFailed();
+
+	// the Reed-Solomon code, symbol i of a codeword is at data[i * stride]
+	// m parity symbols for k data symbols
+	static void rsEncode(const uint8_t *data, uint8_t k, uint8_t *parity, uint8_t m, uint16_t stride);
+	// fill in the erased symbols of an n symbol codeword (n - m data then m parity)
+	static bool rsErasures(uint8_t *code, uint8_t n, uint8_t m, uint16_t stride, const uint8_t *erasures, uint8_t count);
+
+private:
+
+	static void ChunkHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotChunk(uint8_t *data, uint8_t len);
+	void Finish();
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	EBYTE_FECHandler _handler;
+	void *_ctx;
+
+	uint8_t _percent[EBYTE_FEC_CLASSES];
+	uint8_t _chunk;
+
+	// sender
+	uint8_t _tx[EBYTE_FEC_BUFFER];
+	uint8_t _txId;
+	uint8_t _txK;
+	uint8_t _txM;
+	uint8_t _txLen;
+	uint8_t _txNext;
+	bool _sending;
+
+	// receiver
+	uint8_t _rx[EBYTE_FEC_BUFFER];
+	uint8_t _rxId;
+	uint8_t _rxK;
+	uint8_t _rxM;
+	uint8_t _rxLen;
+	uint8_t _rxChunk;
+	uint32_t _rxHave;
+	bool _rxActive;
+	bool _rxDone;
+	unsigned long _rxTime;
+
+	uint32_t _delivered;
+	uint32_t _recovered;
+	uint32_t _failed;
+
+};
+
+#endif
@@ -0,0 +1,238 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Keys.h>
+
+// states
+#define KEY_IDLE 0
+#define KEY_SCHEDULED 1		// waiting for the switch time
+#define KEY_SWITCHING 2		// registers 6 and 7 being written
+#define KEY_SETTLING 3		// switched, waiting for the other nodes to finish
+
+// announcement, op + epoch + key + ms to the switch
+#define KEY_OP_ANNOUNCE 1
+#define KEY_ANNOUNCE_LEN 7
+
+EBYTE_E220_KeyRotation::EBYTE_E220_KeyRotation(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_state = KEY_IDLE;
+	_key = 0;
+	_next = 0;
+	_epoch = 0;
+	_switchAt = 0;
+	_guard = 0;
+	_quietUntil = 0;
+	_announces = 0;
+	_announceAt = 0;
+	_rotations = 0;
+	_failed = 0;
+	_registered = false;
+}
+
+bool EBYTE_E220_KeyRotation::begin(uint16_t key, uint16_t epoch) {
+
+	_key = key;
+	_epoch = epoch;
+	_state = KEY_IDLE;
+
+	// begin() is called again to restart on a known key, the handler only goes in once
+	if (!_registered) {
+		_registered = _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_KEY);
+		if (!_registered) {
+			return false;
+		}
+	}
+
+	_radio->setEncryptonH(key >> 8);
+	_radio->setEncryptonL(key & 0xFF);
+
+	return _radio->saveRegisters(6, 2, EBYTE_WRITE_TEMPORARY);
+}
+
+bool EBYTE_E220_KeyRotation::rotate(uint16_t key, unsigned long in) {
+
+	// the time left goes in 16 bits
+	if (_state != KEY_IDLE || in > 0xFFFF) {
+		return false;
+	}
+
+	Schedule(key, in);
+
+	_announces = EBYTE_KEY_ANNOUNCE;
+	_announceAt = millis();
+
+	return true;
+}
+
+/*
+method to set the switch time, before it nothing may be sent for as long as the longest frame
+takes on air so everything sent under the old key is in before the key changes
+*/
+
+void EBYTE_E220_KeyRotation::Schedule(uint16_t key, unsigned long in) {
+
+	_next = key;
+	_switchAt = millis() + in;
+	_guard = _radio->getAirTime(EBYTE_FRAME_MAX + EBYTE_FRAME_OVERHEAD) / 1000 + EBYTE_KEY_SKEW;
+	_state = KEY_SCHEDULED;
+}
+
+void EBYTE_E220_KeyRotation::Announce() {
+
+	uint8_t frame[KEY_ANNOUNCE_LEN];
+	unsigned long left = _switchAt - millis();
+
+	frame[0] = KEY_OP_ANNOUNCE;
+	frame[1] = (_epoch + 1) >> 8;
+	frame[2] = (_epoch + 1) & 0xFF;
+	frame[3] = _next >> 8;
+	frame[4] = _next & 0xFF;
+	frame[5] = left >> 8;
+	frame[6] = left & 0xFF;
+
+	if (_radio->getTransmissionMethod() == TRM_FIXEDPOINT) {
+		_radio->sendFrame(0xFFFF, _radio->getChannel(), EBYTE_FRAME_KEY, frame, sizeof(frame));
+	}
+	else {
+		_radio->sendFrame(EBYTE_FRAME_KEY, frame, sizeof(frame));
+	}
+}
+
+void EBYTE_E220_KeyRotation::service() {
+
+	unsigned long now = millis();
+
+	if (_state == KEY_SCHEDULED) {
+
+		// announcements stop once the quiet time before the switch starts
+		if (_announces && (long) (now - _announceAt) >= 0 && (long) (_switchAt - now) > (long) _guard && _radio->getAux()) {
+			Announce();
+			_announces--;
+			_announceAt = now + EBYTE_KEY_SPACING;
+		}
+
+		// our last frame has to be off the air before the key changes
+		if ((long) (now - _switchAt) >= 0 && _radio->getAux()) {
+
+			_radio->setEncryptonH(_next >> 8);
+			_radio->setEncryptonL(_next & 0xFF);
+
+			if (_radio->startSave(6, 2, EBYTE_WRITE_TEMPORARY)) {
+				_state = KEY_SWITCHING;
+			}
+			else {
+				_failed++;
+				_radio->setEncryptonH(_key >> 8);
+				_radio->setEncryptonL(_key & 0xFF);
+				_state = KEY_IDLE;
+			}
+		}
+	}
+	else if (_state == KEY_SWITCHING) {
+
+		uint8_t status = _radio->poll();
+
+		if (status == EBYTE_OP_BUSY) {
+			return;
+		}
+
+		if (status == EBYTE_OP_DONE) {
+			_key = _next;
+			_epoch++;
+			_rotations++;
+		}
+		else {
+			_failed++;
+			_radio->setEncryptonH(_key >> 8);
+			_radio->setEncryptonL(_key & 0xFF);
+		}
+
+		// the others may finish a little after us
+		_quietUntil = now + EBYTE_KEY_SKEW;
+		_state = KEY_SETTLING;
+	}
+	else if (_state == KEY_SETTLING) {
+
+		if ((long) (now - _quietUntil) >= 0) {
+			_state = KEY_IDLE;
+		}
+	}
+}
+
+void EBYTE_E220_KeyRotation::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_KeyRotation *) ctx)->GotFrame(data, len);
+}
+
+/*
+an announcement for the next epoch sets (or corrects) the switch time, the time on air is
+taken off what was left when it was sent
+*/
+
+void EBYTE_E220_KeyRotation::GotFrame(uint8_t *data, uint8_t len) {
+
+	if (len != KEY_ANNOUNCE_LEN || data[0] != KEY_OP_ANNOUNCE) {
+		return;
+	}
+
+	uint16_t epoch = ((uint16_t) data[1] << 8) | data[2];
+	uint16_t key = ((uint16_t) data[3] << 8) | data[4];
+	unsigned long left = ((uint16_t) data[5] << 8) | data[6];
+	unsigned long air = _radio->getAirTime(KEY_ANNOUNCE_LEN + EBYTE_FRAME_OVERHEAD) / 1000;
+
+	if (epoch != (uint16_t) (_epoch + 1) || (_state != KEY_IDLE && _state != KEY_SCHEDULED)) {
+		return;
+	}
+
+	Schedule(key, left > air ? left - air : 0);
+}
+
+bool EBYTE_E220_KeyRotation::canSend() {
+
+	if (_state == KEY_IDLE) {
+		return true;
+	}
+
+	if (_state == KEY_SCHEDULED) {
+		return (long) (_switchAt - millis()) > (long) _guard;
+	}
+
+	return false;
+}
+
+bool EBYTE_E220_KeyRotation::pending() {
+	return _state != KEY_IDLE;
+}
+
+uint16_t EBYTE_E220_KeyRotation::getKey() {
+	return _key;
+}
+
+uint16_t EBYTE_E220_KeyRotation::getEpoch() {
+	return _epoch;
+}
+
+uint32_t EBYTE_E220_KeyRotation::getRotations() {
+	return _rotations;
+}
+
+uint32_t EBYTE_E220_KeyRotation::getFailed() {
+	return _failed;
+}
@@ -0,0 +1,131 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Encryption key rotation for the EBYTE_E220 library
+
+  The module's key is 2 bytes in registers 6 and 7, which can only be written (they read back as
+  0). Changing it with saveParameters() sends all 8 registers, and the two ends have to change at
+  the same moment or they stop hearing each other. EBYTE_E220_KeyRotation handles both.
+
+  One node, the coordinator, calls rotate(key, in) with the next key and how long until it takes
+  effect. It announces the new key and its epoch (a count of rotations) a few times, giving each
+  time what's left until the switch, so every node ends up with the same switch time within the
+  air time of the announcement. At that time each node writes only registers 6 and 7 with
+  EBYTE_WRITE_TEMPORARY, without blocking, and the key this layer keeps (getKey()) becomes the new one.
+
+  No frames are lost as long as nothing is sent around the switch: from a guard time before it
+  (long enough for the longest frame to be on air) until the switch is done everywhere canSend()
+  is false. Check it before sending.
+
+  The announcement goes out under the old key, so the new key is only as secret as the old one.
+
+  EBYTE_E220_KeyRotation Keys(&Transceiver, &Receiver);
+
+  Keys.begin(0x1234);							// key all nodes start with
+  ...
+  Keys.rotate(0x5678, 5000);					// coordinator only
+  ...
+  void loop() {
+	Receiver.service();
+	Keys.service();
+	if (Keys.canSend()) {
+		...
+	}
+  }
+
+  A node that missed every announcement is left on the old key, begin() with the current key
+  brings it back
+*/
+
+#ifndef EBYTE_E220_KEYS_H_LIB
+#define EBYTE_E220_KEYS_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// times the coordinator announces a rotation, and the time between announcements (ms)
+#define EBYTE_KEY_ANNOUNCE 3
+#define EBYTE_KEY_SPACING 500
+
+// default time from rotate() to the switch (ms)
+#define EBYTE_KEY_DELAY 5000
+
+// allowance for the nodes' idea of the switch time to differ (ms)
+#define EBYTE_KEY_SKEW 50
+
+class EBYTE_E220_KeyRotation {
+
+public:
+
+	EBYTE_E220_KeyRotation(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	// writes the key to the module (blocking), call after init(), again to restart on a known key.
+	// false if the write failed or the receiver had no room for the handler
+	bool begin(uint16_t key, uint16_t epoch = 0);
+
+	// coordinator, announce the next key to take effect in ms (up to 65535), false if a rotation
+	// is already under way
+	bool rotate(uint16_t key, unsigned long in = EBYTE_KEY_DELAY);
+
+	void service();
+
+	bool canSend();
+	bool pending();				// a rotation is scheduled or in progress
+
+	uint16_t getKey();
+	uint16_t getEpoch();
+	uint32_t getRotations();
+	uint32_t getFailed();		// register writes that failed, the old key is kept
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotFrame(uint8_t *data, uint8_t len);
+	void Announce();
+	void Schedule(uint16_t key, unsigned long in);
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	uint8_t _state;
+	uint16_t _key;
+	uint16_t _next;
+	uint16_t _epoch;
+	unsigned long _switchAt;
+	unsigned long _guard;
+	unsigned long _quietUntil;
+
+	uint8_t _announces;
+	unsigned long _announceAt;
+
+	uint32_t _rotations;
+	uint32_t _failed;
+
+	bool _registered;			// FrameHandler is on the receiver
+
+};
+
+#endif
@@ -0,0 +1,446 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_LinkTest.h>
+
+// first byte of every link test frame
+#define LINK_PING 1
+#define LINK_PONG 2
+#define LINK_CONFIG 3
+#define LINK_CONFIG_ACK 4
+#define LINK_RESTORE 5
+#define LINK_RESTORE_ACK 6
+
+// op, seq and two argument bytes
+#define LINK_HEADER 4
+
+// initiator states
+#define STATE_IDLE 0
+#define STATE_CONFIG 1
+#define STATE_PING 2
+#define STATE_RESTORE 3
+#define STATE_WAIT 4
+#define STATE_DONE 5
+
+EBYTE_E220_LinkTest::EBYTE_E220_LinkTest(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_initiator = false;
+	_state = STATE_IDLE;
+	_baseRate = 0;
+	_baseSize = 0;
+	_onTest = false;
+	_applyRate = 0;
+	_applySize = 0;
+	_applyPending = false;
+	_lastHeard = 0;
+	_rates = NULL;
+	_sizes = NULL;
+	_rateCount = 0;
+	_sizeCount = 0;
+	_combination = 0;
+	_pings = EBYTE_LINK_PINGS;
+	_payload = 32;
+	_seq = 0;
+	_tries = 0;
+	_waiting = false;
+	_answered = false;
+	_sentAt = 0;
+	_runStart = 0;
+	_got = 0;
+	_resultCount = 0;
+
+	memset(_rtt, 0, sizeof(_rtt));
+	memset(_results, 0, sizeof(_results));
+}
+
+bool EBYTE_E220_LinkTest::beginResponder() {
+
+	_initiator = false;
+	_state = STATE_IDLE;
+	_baseRate = _radio->getAirDataRate();
+	_baseSize = _radio->getPacketSize();
+	_onTest = false;
+
+	return _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_LINK);
+}
+
+/*
+the sweep is every rate with every size, rates in the outer loop
+*/
+
+bool EBYTE_E220_LinkTest::beginInitiator(const uint8_t *rates, uint8_t rateCount, const uint8_t *sizes, uint8_t sizeCount, uint8_t pings) {
+
+	_initiator = true;
+	_baseRate = _radio->getAirDataRate();
+	_baseSize = _radio->getPacketSize();
+	_onTest = false;
+
+	_rates = rates;
+	_sizes = sizes;
+	_rateCount = rateCount;
+	_sizeCount = sizeCount;
+	_pings = constrain(pings, 1, EBYTE_LINK_PINGS);
+	_combination = 0;
+	_resultCount = 0;
+
+	if (!_receiver->onFrame(FrameHandler, this, EBYTE_FRAME_LINK)) {
+		return false;
+	}
+
+	NextCombination();
+	return true;
+}
+
+void EBYTE_E220_LinkTest::setPayload(uint8_t len) {
+	_payload = len;
+}
+
+/*
+settings changes are done here and not from the frame handler, the register write
+changes mode and that drains the receiver we were called from
+*/
+
+void EBYTE_E220_LinkTest::service() {
+
+	unsigned long now = millis();
+
+	if (!_initiator) {
+
+		if (_applyPending) {
+			// let the ack get out on the old settings first
+			if (_radio->getAux()) {
+				_applyPending = false;
+				Apply(_applyRate, _applySize);
+				_onTest = (_applyRate != _baseRate) || (_applySize != _baseSize);
+				_lastHeard = millis();
+			}
+		}
+		else if (_onTest && (now - _lastHeard) >= EBYTE_LINK_REVERT) {
+			// the initiator is gone or can't reach us on these settings
+			Apply(_baseRate, _baseSize);
+			_onTest = false;
+		}
+		return;
+	}
+
+	if (_state == STATE_IDLE || _state == STATE_DONE || !_radio->getAux()) {
+		return;
+	}
+
+	EBYTE_LinkResult *r = &_results[_resultCount];
+
+	switch (_state) {
+
+	case STATE_CONFIG:
+		if (_answered) {
+			Apply(r->AirDataRate, r->PacketSize);
+			_onTest = true;
+			_waiting = false;
+			_answered = false;
+			_seq = 0;
+			_state = STATE_PING;
+		}
+		else if (!_waiting || (now - _sentAt) >= Timeout()) {
+			if (_tries >= EBYTE_LINK_RETRIES) {
+				// the responder may have switched and lost our ack, give it time to come back
+				_sentAt = now;
+				_state = STATE_WAIT;
+				break;
+			}
+			_tries++;
+			_waiting = true;
+			_sentAt = now;
+			Send(LINK_CONFIG, 0, r->AirDataRate, r->PacketSize, 0);
+		}
+		break;
+
+	case STATE_PING:
+		if (_waiting && !_answered && (now - _sentAt) < Timeout()) {
+			break;
+		}
+		if (_waiting) {
+			// answered or timed out, either way this ping is finished
+			_waiting = false;
+			_answered = false;
+			if (r->Sent >= _pings) {
+				FinishCombination();
+				break;
+			}
+		}
+		if (r->Sent == 0) {
+			_runStart = micros();
+			_got = 0;
+		}
+		_waiting = true;
+		_answered = false;
+		_seq = r->Sent;
+		_sentAt = millis();
+		_rtt[_seq] = micros();
+		r->Sent++;
+		Send(LINK_PING, _seq, 0, 0, r->Payload);
+		break;
+
+	case STATE_RESTORE:
+		if (_answered || _tries >= EBYTE_LINK_RETRIES) {
+			Apply(_baseRate, _baseSize);
+			_onTest = false;
+			_sentAt = millis();
+			// no ack, the responder falls back by itself after EBYTE_LINK_REVERT
+			_state = _answered ? STATE_IDLE : STATE_WAIT;
+			_answered = false;
+			if (_state == STATE_IDLE) {
+				_resultCount++;
+				NextCombination();
+			}
+		}
+		else if (!_waiting || (now - _sentAt) >= Timeout()) {
+			_tries++;
+			_waiting = true;
+			_sentAt = now;
+			Send(LINK_RESTORE, 0, 0, 0, 0);
+		}
+		break;
+
+	case STATE_WAIT:
+		if ((now - _sentAt) >= EBYTE_LINK_REVERT + EBYTE_LINK_GUARD) {
+			_resultCount++;
+			NextCombination();
+		}
+		break;
+	}
+}
+
+bool EBYTE_E220_LinkTest::done() {
+	return _state == STATE_DONE;
+}
+
+uint8_t EBYTE_E220_LinkTest::getResultCount() {
+	return _resultCount;
+}
+
+EBYTE_LinkResult *EBYTE_E220_LinkTest::getResult(uint8_t i) {
+	return (i < _resultCount) ? &_results[i] : NULL;
+}
+
+/*
+method to print the results, one line per combination, times in ms
+*/
+
+void EBYTE_E220_LinkTest::printResults(Print *p) {
+
+	p->println(F("   rate  sub len sent recv  loss%   min_ms   p50_ms   p90_ms   max_ms    B/s"));
+
+	for (uint8_t i = 0; i < _resultCount; i++) {
+
+		EBYTE_LinkResult *r = &_results[i];
+		char line[96];
+		uint8_t loss = r->Sent ? (uint8_t) ((100UL * (r->Sent - r->Received)) / r->Sent) : 100;
+
+		if (r->Received == 0) {
+			snprintf(line, sizeof(line), "%7lu %4u %3u %4u %4u %6u        -        -        -        -      0",
+				(unsigned long) EBYTE_AirDataRate(r->AirDataRate), EBYTE_PacketBytes(r->PacketSize),
+				r->Payload, r->Sent, r->Received, loss);
+		}
+		else {
+			snprintf(line, sizeof(line), "%7lu %4u %3u %4u %4u %6u %8lu %8lu %8lu %8lu %6lu",
+				(unsigned long) EBYTE_AirDataRate(r->AirDataRate), EBYTE_PacketBytes(r->PacketSize),
+				r->Payload, r->Sent, r->Received, loss,
+				(unsigned long) (r->RTTMin / 1000), (unsigned long) (r->RTTMedian / 1000),
+				(unsigned long) (r->RTT90 / 1000), (unsigned long) (r->RTTMax / 1000),
+				(unsigned long) r->Goodput);
+		}
+		p->println(line);
+	}
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_LinkTest::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_LinkTest*) ctx)->GotFrame(data, len);
+}
+
+void EBYTE_E220_LinkTest::GotFrame(uint8_t *data, uint8_t len) {
+
+	if (len < LINK_HEADER) {
+		return;
+	}
+
+	uint8_t op = data[0];
+	uint8_t seq = data[1];
+
+	if (!_initiator) {
+
+		_lastHeard = millis();
+
+		switch (op) {
+		case LINK_PING:
+			Send(LINK_PONG, seq, 0, 0, len - LINK_HEADER);
+			break;
+		case LINK_CONFIG:
+			Send(LINK_CONFIG_ACK, 0, data[2], data[3], 0);
+			_applyRate = data[2];
+			_applySize = data[3];
+			_applyPending = true;
+			break;
+		case LINK_RESTORE:
+			Send(LINK_RESTORE_ACK, 0, 0, 0, 0);
+			_applyRate = _baseRate;
+			_applySize = _baseSize;
+			_applyPending = true;
+			break;
+		}
+		return;
+	}
+
+	if (!_waiting || _answered) {
+		return;
+	}
+
+	switch (_state) {
+	case STATE_CONFIG:
+		_answered = (op == LINK_CONFIG_ACK);
+		break;
+	case STATE_PING:
+		if (op == LINK_PONG && seq == _seq) {
+			// _rtt held the send time until now
+			_rtt[seq] = micros() - _rtt[seq];
+			_got |= (1UL << seq);
+			_results[_resultCount].Received++;
+			_answered = true;
+		}
+		break;
+	case STATE_RESTORE:
+		_answered = (op == LINK_RESTORE_ACK);
+		break;
+	}
+}
+
+void EBYTE_E220_LinkTest::Send(uint8_t op, uint8_t seq, uint8_t a, uint8_t b, uint8_t pad) {
+
+	uint8_t buf[EBYTE_FRAME_MAX];
+	uint8_t len = min((uint16_t) (LINK_HEADER + pad), (uint16_t) EBYTE_FRAME_MAX);
+
+	buf[0] = op;
+	buf[1] = seq;
+	buf[2] = a;
+	buf[3] = b;
+	for (uint8_t i = LINK_HEADER; i < len; i++) {
+		buf[i] = seq + i;
+	}
+
+	_radio->sendFrame(EBYTE_FRAME_LINK, buf, len);
+}
+
+/*
+both ends switch with a temporary write so a power cycle always brings the module back as it was
+REG0 holds the air data rate and REG1 the sub packet size
+*/
+
+void EBYTE_E220_LinkTest::Apply(uint8_t rate, uint8_t size) {
+
+	if (rate == _radio->getAirDataRate() && size == _radio->getPacketSize()) {
+		return;
+	}
+
+	_radio->setAirDataRate(rate);
+	_radio->setPacketSize(size);
+	_radio->saveRegisters(2, 2, EBYTE_WRITE_TEMPORARY);
+}
+
+/*
+set up the next result slot, the ping fills one sub packet (or setPayload() if that's less)
+*/
+
+void EBYTE_E220_LinkTest::NextCombination() {
+
+	if (_combination >= (uint16_t) _rateCount * _sizeCount || _resultCount >= EBYTE_LINK_RESULTS) {
+		_state = STATE_DONE;
+		return;
+	}
+
+	EBYTE_LinkResult *r = &_results[_resultCount];
+	uint8_t room = EBYTE_PacketBytes(_sizes[_combination % _sizeCount]) - EBYTE_FRAME_OVERHEAD - LINK_HEADER;
+
+	memset(r, 0, sizeof(EBYTE_LinkResult));
+	r->AirDataRate = _rates[_combination / _sizeCount];
+	r->PacketSize = _sizes[_combination % _sizeCount];
+	r->Payload = min(_payload, room);
+
+	_combination++;
+	_tries = 0;
+	_waiting = false;
+	_answered = false;
+	_state = STATE_CONFIG;
+}
+
+/*
+sort the round trip times for the percentiles, goodput is the payload echoed over the whole run
+*/
+
+void EBYTE_E220_LinkTest::FinishCombination() {
+
+	EBYTE_LinkResult *r = &_results[_resultCount];
+	unsigned long elapsed = micros() - _runStart;
+	uint8_t n = 0;
+
+	// only answered pings hold a time, lost ones still hold their send time
+	for (uint8_t i = 0; i < r->Sent; i++) {
+		if (_got & (1UL << i)) {
+			_rtt[n++] = _rtt[i];
+		}
+	}
+
+	for (uint8_t i = 1; i < n; i++) {
+		uint32_t v = _rtt[i];
+		uint8_t j = i;
+		while (j > 0 && _rtt[j - 1] > v) {
+			_rtt[j] = _rtt[j - 1];
+			j--;
+		}
+		_rtt[j] = v;
+	}
+
+	if (n) {
+		r->RTTMin = _rtt[0];
+		r->RTTMedian = _rtt[(n - 1) / 2];
+		r->RTT90 = _rtt[((n - 1) * 9) / 10];
+		r->RTTMax = _rtt[n - 1];
+	}
+	if (elapsed) {
+		r->Goodput = (uint32_t) (((uint64_t) r->Received * r->Payload * 1000000UL) / elapsed);
+	}
+
+	_tries = 0;
+	_waiting = false;
+	_answered = false;
+	_state = STATE_RESTORE;
+}
+
+// time to wait for an answer, there and back on air plus a guard
+
+unsigned long EBYTE_E220_LinkTest::Timeout() {
+
+	unsigned long air = _radio->getAirTime(EBYTE_FRAME_OVERHEAD + LINK_HEADER + _results[_resultCount].Payload) / 1000;
+
+	return (2 * air) + EBYTE_LINK_GUARD;
+}
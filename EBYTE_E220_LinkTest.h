@@ -0,0 +1,160 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Link benchmark for the EBYTE_E220 library
+
+  Stop picking air data rate and packet size by trial and error. One module runs as the responder
+  (it echos pings and follows the initiator's settings), the other as the initiator. For each
+  combination of air data rate and sub packet size the initiator
+  1. tells the responder the settings to use, both switch with a temporary register write
+  2. sends pings one at a time and times the echo
+  3. tells the responder to go back, both return to the settings they started with
+  and keeps the round trip time distribution, loss and goodput for each combination
+
+  If the responder hears nothing for EBYTE_LINK_REVERT ms on test settings it goes back on its own,
+  so a combination that doesn't work can't strand it
+
+  const uint8_t Rates[] = {ADR_2400, ADR_9600, ADR_38400};
+  const uint8_t Sizes[] = {SUB_32BYTES, SUB_200BYTES};
+
+  initiator: Test.beginInitiator(Rates, 3, Sizes, 2);
+             while (!Test.done()) { Receiver.service(); Test.service(); }
+             Test.printResults(&Serial);
+  responder: Test.beginResponder();
+             loop() { Receiver.service(); Test.service(); }
+
+  Runs the same against two linked EBYTE_E220_Sim objects
+*/
+
+#ifndef EBYTE_E220_LINKTEST_H_LIB
+#define EBYTE_E220_LINKTEST_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// most pings per combination, 32 at most (round trip times are kept for the percentiles)
+#ifndef EBYTE_LINK_PINGS
+#define EBYTE_LINK_PINGS 10
+#endif
+
+// most combinations
+#ifndef EBYTE_LINK_RESULTS
+#define EBYTE_LINK_RESULTS 24
+#endif
+
+// extra time allowed for an answer on top of the air time there and back (ms)
+#define EBYTE_LINK_GUARD 250
+
+// responder returns to its own settings after this long without hearing anything (ms)
+#define EBYTE_LINK_REVERT 5000
+
+// times a command is sent before giving up
+#define EBYTE_LINK_RETRIES 3
+
+struct EBYTE_LinkResult {
+	uint8_t AirDataRate;
+	uint8_t PacketSize;
+	uint8_t Payload;
+	uint8_t Sent;
+	uint8_t Received;
+	uint32_t RTTMin;		// us
+	uint32_t RTTMedian;
+	uint32_t RTT90;
+	uint32_t RTTMax;
+	uint32_t Goodput;		// payload bytes per second
+};
+
+class EBYTE_E220_LinkTest {
+
+public:
+
+	EBYTE_E220_LinkTest(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	bool beginResponder();
+	bool beginInitiator(const uint8_t *rates, uint8_t rateCount, const uint8_t *sizes, uint8_t sizeCount, uint8_t pings = EBYTE_LINK_PINGS);
+
+	// ping payload, clipped to what fits in one sub packet
+	void setPayload(uint8_t len);
+
+	// call often (after Receiver.service())
+	void service();
+
+	bool done();
+
+	uint8_t getResultCount();
+	EBYTE_LinkResult *getResult(uint8_t i);
+	void printResults(Print *p);
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotFrame(uint8_t *data, uint8_t len);
+	void Send(uint8_t op, uint8_t seq, uint8_t a, uint8_t b, uint8_t pad);
+	void Apply(uint8_t rate, uint8_t size);
+	void NextCombination();
+	void FinishCombination();
+	unsigned long Timeout();
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	bool _initiator;
+	uint8_t _state;
+
+	// settings we started with
+	uint8_t _baseRate;
+	uint8_t _baseSize;
+	bool _onTest;
+
+	// responder, settings change waiting for its ack to go out
+	uint8_t _applyRate;
+	uint8_t _applySize;
+	bool _applyPending;
+	unsigned long _lastHeard;
+
+	// initiator
+	const uint8_t *_rates;
+	const uint8_t *_sizes;
+	uint8_t _rateCount;
+	uint8_t _sizeCount;
+	uint8_t _combination;
+	uint8_t _pings;
+	uint8_t _payload;
+	uint8_t _seq;
+	uint8_t _tries;
+	bool _waiting;
+	bool _answered;
+	unsigned long _sentAt;
+	unsigned long _runStart;
+	uint32_t _rtt[EBYTE_LINK_PINGS];
+	uint32_t _got;					// bit i set, ping i was answered
+
+	EBYTE_LinkResult _results[EBYTE_LINK_RESULTS];
+	uint8_t _resultCount;
+
+};
+
+#endif
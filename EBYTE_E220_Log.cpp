@@ -0,0 +1,114 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Log.h>
+
+#if EBYTE_LOG_LEVEL > EBYTE_LOG_NONE
+
+static EBYTE_LogSink Sink = NULL;
+
+static EBYTE_LogEntry Entries[EBYTE_LOG_BUFFER];
+static volatile uint8_t Head = 0;
+static volatile uint8_t Count = 0;
+
+void EBYTE_setLogSink(EBYTE_LogSink sink) {
+	Sink = sink;
+}
+
+void EBYTE_Log(uint8_t level, uint8_t code, int32_t arg) {
+	if (Sink) {
+		Sink(level, code, arg);
+	}
+}
+
+/*
+sink that prints right away, this blocks for as long as Serial takes to send the line
+*/
+
+void EBYTE_LogToSerial(uint8_t level, uint8_t code, int32_t arg) {
+
+	Serial.print(F("EBYTE_E220 L"));
+	Serial.print(level);
+	Serial.print(F(" C"));
+	Serial.print(code);
+	Serial.print(F(" "));
+	Serial.println(arg);
+}
+
+/*
+sink that just stores the entry, when full the oldest entry is overwritten
+*/
+
+void EBYTE_LogToBuffer(uint8_t level, uint8_t code, int32_t arg) {
+
+	uint8_t i = (Head + Count) % EBYTE_LOG_BUFFER;
+
+	Entries[i].Time = millis();
+	Entries[i].Level = level;
+	Entries[i].Code = code;
+	Entries[i].Arg = arg;
+
+	if (Count < EBYTE_LOG_BUFFER) {
+		Count++;
+	}
+	else {
+		Head = (Head + 1) % EBYTE_LOG_BUFFER;
+	}
+}
+
+bool EBYTE_LogRead(EBYTE_LogEntry *entry) {
+
+	if (Count == 0) {
+		return false;
+	}
+
+	*entry = Entries[Head];
+	Head = (Head + 1) % EBYTE_LOG_BUFFER;
+	Count--;
+
+	return true;
+}
+
+void EBYTE_LogDump(Print *p) {
+
+	EBYTE_LogEntry e;
+
+	while (EBYTE_LogRead(&e)) {
+		p->print(e.Time);
+		p->print(F(" L"));
+		p->print(e.Level);
+		p->print(F(" C"));
+		p->print(e.Code);
+		p->print(F(" "));
+		p->println(e.Arg);
+	}
+}
+
+#else
+
+// logging compiled out, keep the API so sketches still build
+
+void EBYTE_setLogSink(EBYTE_LogSink sink) { (void) sink; }
+void EBYTE_Log(uint8_t level, uint8_t code, int32_t arg) { (void) level; (void) code; (void) arg; }
+void EBYTE_LogToSerial(uint8_t level, uint8_t code, int32_t arg) { (void) level; (void) code; (void) arg; }
+void EBYTE_LogToBuffer(uint8_t level, uint8_t code, int32_t arg) { (void) level; (void) code; (void) arg; }
+bool EBYTE_LogRead(EBYTE_LogEntry *entry) { (void) entry; return false; }
+void EBYTE_LogDump(Print *p) { (void) p; }
+
+#endif
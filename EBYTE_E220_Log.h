@@ -0,0 +1,117 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Logging for the EBYTE_E220 library
+
+  The library never prints on its own. Errors and diagnostics are reported as a level, a code and
+  a numeric argument to a sink function you install with EBYTE_setLogSink(). With no sink installed
+  nothing is done. Two sinks are provided
+  1. EBYTE_LogToSerial, prints each entry to Serial as it happens (blocking, handy while debugging)
+  2. EBYTE_LogToBuffer, stores entries in a small ring buffer, call EBYTE_LogDump() from loop()
+     when you have time to print them (non-blocking, safe if the radio is on Serial)
+
+  Levels above EBYTE_LOG_LEVEL are compiled out completely. Set EBYTE_LOG_LEVEL to EBYTE_LOG_NONE
+  to remove all logging code from the library
+*/
+
+#ifndef EBYTE_E220_LOG_H_LIB
+#define EBYTE_E220_LOG_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+// log levels
+#define EBYTE_LOG_NONE 0
+#define EBYTE_LOG_ERROR 1
+#define EBYTE_LOG_WARN 2
+#define EBYTE_LOG_INFO 3
+#define EBYTE_LOG_DEBUG 4
+
+// change this (or pass -DEBYTE_LOG_LEVEL=x as a build flag) to get more or less logging
+#ifndef EBYTE_LOG_LEVEL
+#define EBYTE_LOG_LEVEL EBYTE_LOG_ERROR
+#endif
+
+// number of entries held by EBYTE_LogToBuffer, oldest entries are dropped when full
+#ifndef EBYTE_LOG_BUFFER
+#define EBYTE_LOG_BUFFER 16
+#endif
+
+// log codes (arg meaning in brackets)
+#define EBYTE_ERR_TASK_TIMEOUT 1		// AUX stayed low past the timeout (ms waited)
+#define EBYTE_ERR_CLEAR_TIMEOUT 2		// ClearBuffer() could not empty the buffer (bytes discarded)
+#define EBYTE_ERR_READ_MODEL 3			// init() could not read the model (AT status, EBYTE_AT_OK if it isn't an E220)
+#define EBYTE_ERR_READ_VERSION 4		// init() could not read the version (AT status)
+#define EBYTE_ERR_READ_PARAMS 5			// parameter read failed (first byte returned)
+#define EBYTE_ERR_SAVE_PARAMS 6			// parameter write not acknowledged (first byte returned)
+#define EBYTE_ERR_TX_TIMEOUT 7			// queued send kept AUX low past the timeout (ms waited)
+#define EBYTE_ERR_HANDLERS_FULL 8		// onFrame() had no room for another handler (frame type)
+#define EBYTE_LOG_REG_WRITE 20			// register being written ((register << 8) | value)
+#define EBYTE_LOG_REG_READ 21			// register read back ((register << 8) | value)
+#define EBYTE_LOG_TX_BACKOFF 22			// channel busy before a queued send (ms backing off)
+
+typedef void (*EBYTE_LogSink)(uint8_t level, uint8_t code, int32_t arg);
+
+struct EBYTE_LogEntry {
+	unsigned long Time;
+	uint8_t Level;
+	uint8_t Code;
+	int32_t Arg;
+};
+
+void EBYTE_setLogSink(EBYTE_LogSink sink);
+void EBYTE_Log(uint8_t level, uint8_t code, int32_t arg);
+
+// ready made sinks
+void EBYTE_LogToSerial(uint8_t level, uint8_t code, int32_t arg);
+void EBYTE_LogToBuffer(uint8_t level, uint8_t code, int32_t arg);
+
+// methods to drain entries stored by EBYTE_LogToBuffer
+bool EBYTE_LogRead(EBYTE_LogEntry *entry);
+void EBYTE_LogDump(Print *p);
+
+#if EBYTE_LOG_LEVEL >= EBYTE_LOG_ERROR
+#define EBYTE_LOGE(code, arg) EBYTE_Log(EBYTE_LOG_ERROR, (code), (int32_t) (arg))
+#else
+#define EBYTE_LOGE(code, arg) ((void) 0)
+#endif
+
+#if EBYTE_LOG_LEVEL >= EBYTE_LOG_WARN
+#define EBYTE_LOGW(code, arg) EBYTE_Log(EBYTE_LOG_WARN, (code), (int32_t) (arg))
+#else
+#define EBYTE_LOGW(code, arg) ((void) 0)
+#endif
+
+#if EBYTE_LOG_LEVEL >= EBYTE_LOG_INFO
+#define EBYTE_LOGI(code, arg) EBYTE_Log(EBYTE_LOG_INFO, (code), (int32_t) (arg))
+#else
+#define EBYTE_LOGI(code, arg) ((void) 0)
+#endif
+
+#if EBYTE_LOG_LEVEL >= EBYTE_LOG_DEBUG
+#define EBYTE_LOGD(code, arg) EBYTE_Log(EBYTE_LOG_DEBUG, (code), (int32_t) (arg))
+#else
+#define EBYTE_LOGD(code, arg) ((void) 0)
+#endif
+
+#endif
@@ -0,0 +1,258 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Manager.h>
+
+#define MANAGER_MODE 1
+#define MANAGER_SAVE 2
+#define MANAGER_READ 3
+
+EBYTE_E220_Manager::EBYTE_E220_Manager() {
+
+	_count = 0;
+	_failed = false;
+	_handler = NULL;
+	_ctx = NULL;
+
+	memset(_modules, 0, sizeof(_modules));
+}
+
+bool EBYTE_E220_Manager::add(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	if (_count >= EBYTE_MANAGER_MODULES) {
+		return false;
+	}
+
+	Module *m = &_modules[_count++];
+
+	memset(m, 0, sizeof(Module));
+	m->Radio = radio;
+	m->Receiver = receiver;
+	m->Status = EBYTE_OP_IDLE;
+
+	return true;
+}
+
+uint8_t EBYTE_E220_Manager::getCount() {
+	return _count;
+}
+
+EBYTE_E220 *EBYTE_E220_Manager::getModule(uint8_t module) {
+	return module < _count ? _modules[module].Radio : NULL;
+}
+
+void EBYTE_E220_Manager::onDone(EBYTE_ManagerHandler handler, void *ctx) {
+	_handler = handler;
+	_ctx = ctx;
+}
+
+bool EBYTE_E220_Manager::setMode(uint8_t module, uint8_t mode) {
+	return Queue(module, MANAGER_MODE, mode, 0, 0, 0);
+}
+
+bool EBYTE_E220_Manager::save(uint8_t module, uint8_t start, uint8_t count, uint8_t val) {
+
+	if ((start + count) > 8 || count == 0) {
+		return false;
+	}
+
+	return Queue(module, MANAGER_SAVE, 0, start, count, val);
+}
+
+bool EBYTE_E220_Manager::read(uint8_t module) {
+	return Queue(module, MANAGER_READ, 0, 0, 0, 0);
+}
+
+bool EBYTE_E220_Manager::setModeAll(uint8_t mode) {
+
+	bool ok = true;
+
+	for (uint8_t i = 0; i < _count; i++) {
+		ok &= setMode(i, mode);
+	}
+
+	return ok;
+}
+
+bool EBYTE_E220_Manager::saveAll(uint8_t start, uint8_t count, uint8_t val) {
+
+	bool ok = true;
+
+	for (uint8_t i = 0; i < _count; i++) {
+		ok &= save(i, start, count, val);
+	}
+
+	return ok;
+}
+
+bool EBYTE_E220_Manager::readAll() {
+
+	bool ok = true;
+
+	for (uint8_t i = 0; i < _count; i++) {
+		ok &= read(i);
+	}
+
+	return ok;
+}
+
+bool EBYTE_E220_Manager::Queue(uint8_t module, uint8_t type, uint8_t mode, uint8_t start, uint8_t count, uint8_t val) {
+
+	if (module >= _count) {
+		return false;
+	}
+
+	Module *m = &_modules[module];
+
+	if (m->Count >= EBYTE_MANAGER_OPS) {
+		return false;
+	}
+
+	Op *op = &m->Ops[(m->Head + m->Count) % EBYTE_MANAGER_OPS];
+
+	op->Type = type;
+	op->Mode = mode;
+	op->Start = start;
+	op->Count = count;
+	op->Val = val;
+	m->Count++;
+
+	return true;
+}
+
+/*
+method to start the operation at the head of a module's queue
+*/
+
+bool EBYTE_E220_Manager::Start(Module *m) {
+
+	Op *op = &m->Ops[m->Head];
+
+	m->Started = millis();
+
+	if (op->Type == MANAGER_MODE) {
+		return m->Radio->startMode(op->Mode);
+	}
+	if (op->Type == MANAGER_SAVE) {
+		return m->Radio->startSave(op->Start, op->Count, op->Val);
+	}
+
+	return m->Radio->startRead();
+}
+
+/*
+method to step every module once, none of this waits so a module that is between steps
+costs next to nothing
+*/
+
+void EBYTE_E220_Manager::service() {
+
+	for (uint8_t i = 0; i < _count; i++) {
+
+		Module *m = &_modules[i];
+
+		if (m->Running) {
+
+			uint8_t status = m->Radio->poll();
+
+			if (status == EBYTE_OP_BUSY) {
+				continue;
+			}
+
+			m->Running = false;
+			m->Time = millis() - m->Started;
+			m->Status = status;
+			m->Head = (m->Head + 1) % EBYTE_MANAGER_OPS;
+			m->Count--;
+
+			if (status != EBYTE_OP_DONE) {
+				m->Failed++;
+				_failed = true;
+			}
+
+			if (_handler) {
+				_handler(i, status, _ctx);
+			}
+		}
+
+		if (m->Count) {
+
+			if (Start(m)) {
+				m->Running = true;
+			}
+			else {
+				// the module already had something running that we didn't start
+				m->Status = EBYTE_OP_FAILED;
+				m->Failed++;
+				_failed = true;
+				m->Head = (m->Head + 1) % EBYTE_MANAGER_OPS;
+				m->Count--;
+			}
+			continue;
+		}
+
+		if (m->Receiver) {
+			m->Receiver->service();
+		}
+	}
+}
+
+bool EBYTE_E220_Manager::busy() {
+
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_modules[i].Count) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool EBYTE_E220_Manager::busy(uint8_t module) {
+	return module < _count && _modules[module].Count;
+}
+
+bool EBYTE_E220_Manager::wait(unsigned long timeout) {
+
+	unsigned long t = millis();
+
+	_failed = false;
+
+	while (busy()) {
+		service();
+		if ((millis() - t) > timeout) {
+			return false;
+		}
+		yield();
+	}
+
+	return !_failed;
+}
+
+uint8_t EBYTE_E220_Manager::getStatus(uint8_t module) {
+	return module < _count ? _modules[module].Status : EBYTE_OP_IDLE;
+}
+
+unsigned long EBYTE_E220_Manager::getTime(uint8_t module) {
+	return module < _count ? _modules[module].Time : 0;
+}
+
+uint16_t EBYTE_E220_Manager::getFailed(uint8_t module) {
+	return module < _count ? _modules[module].Failed : 0;
+}
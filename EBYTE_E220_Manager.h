@@ -0,0 +1,142 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Several EBYTE_E220 modules run from one loop
+
+  A gateway with a module on each channel can't afford setMode() and saveParameters() on each in
+  turn, every one of them waits hundreds of milliseconds with the others idle. The manager owns the
+  modules, gives each a short queue of operations (mode changes, register writes, register reads)
+  and runs them with the non blocking startMode() / startSave() / startRead() and poll() of
+  EBYTE_E220, all from service(). The waits overlap, so configuring every module takes about as
+  long as the slowest one. Modules with nothing to do have their receivers serviced.
+
+  EBYTE_E220_Manager Manager;
+
+  Manager.add(&Transceiver1, &Receiver1);
+  Manager.add(&Transceiver2, &Receiver2);
+  ...
+  Transceiver1.setChannel(10);
+  Transceiver2.setChannel(20);
+  Manager.save(0, 4, 1, EBYTE_WRITE_TEMPORARY);		// module 0, REG2 only
+  Manager.save(1, 4, 1, EBYTE_WRITE_TEMPORARY);
+  ...
+  void loop() {
+	Manager.service();
+	if (!Manager.busy()) {
+		...
+	}
+  }
+
+  Don't call the blocking methods of a module while the manager has something running on it
+*/
+
+#ifndef EBYTE_E220_MANAGER_H_LIB
+#define EBYTE_E220_MANAGER_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// modules one manager can own
+#ifndef EBYTE_MANAGER_MODULES
+#define EBYTE_MANAGER_MODULES 8
+#endif
+
+// operations waiting per module
+#define EBYTE_MANAGER_OPS 4
+
+// called when an operation is over, status is EBYTE_OP_DONE or EBYTE_OP_FAILED
+typedef void (*EBYTE_ManagerHandler)(uint8_t module, uint8_t status, void *ctx);
+
+class EBYTE_E220_Manager {
+
+public:
+
+	EBYTE_E220_Manager();
+
+	bool add(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver = NULL);
+	uint8_t getCount();
+	EBYTE_E220 *getModule(uint8_t module);
+
+	void onDone(EBYTE_ManagerHandler handler, void *ctx);
+
+	// queue an operation, false if the module's queue is full
+	bool setMode(uint8_t module, uint8_t mode);
+	bool save(uint8_t module, uint8_t start = 0, uint8_t count = 8, uint8_t val = EBYTE_WRITE_PERMANENT);
+	bool read(uint8_t module);
+
+	// the same for every module
+	bool setModeAll(uint8_t mode);
+	bool saveAll(uint8_t start = 0, uint8_t count = 8, uint8_t val = EBYTE_WRITE_PERMANENT);
+	bool readAll();
+
+	void service();
+
+	bool busy();
+	bool busy(uint8_t module);
+
+	// blocks, running service() until nothing is queued, false on timeout or if anything failed
+	bool wait(unsigned long timeout = 10000);
+
+	uint8_t getStatus(uint8_t module);			// of the last operation
+	unsigned long getTime(uint8_t module);		// ms the last operation took
+	uint16_t getFailed(uint8_t module);
+
+private:
+
+	struct Op {
+		uint8_t Type;
+		uint8_t Mode;
+		uint8_t Start;
+		uint8_t Count;
+		uint8_t Val;
+	};
+
+	struct Module {
+		EBYTE_E220 *Radio;
+		EBYTE_E220_Receiver *Receiver;
+		Op Ops[EBYTE_MANAGER_OPS];
+		uint8_t Head;
+		uint8_t Count;
+		bool Running;
+		unsigned long Started;
+		unsigned long Time;
+		uint8_t Status;
+		uint16_t Failed;
+	};
+
+	bool Queue(uint8_t module, uint8_t type, uint8_t mode, uint8_t start, uint8_t count, uint8_t val);
+	bool Start(Module *m);
+
+	Module _modules[EBYTE_MANAGER_MODULES];
+	uint8_t _count;
+	bool _failed;
+
+	EBYTE_ManagerHandler _handler;
+	void *_ctx;
+
+};
+
+#endif
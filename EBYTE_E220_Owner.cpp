@@ -0,0 +1,386 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Owner.h>
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+#define OWNER_MODE 1
+#define OWNER_SAVE 2
+#define OWNER_READ 3
+#define OWNER_SEND 4
+#define OWNER_SEND_FIXED 5
+
+/*
+the few atomic operations the queue needs. AVR has no compare and swap, but nothing else runs
+while interrupts are off, everywhere else the GCC builtins do it (acquire on loads, release on
+stores, so a slot's contents are seen before its sequence number)
+*/
+
+#if defined(__AVR__)
+
+static uint32_t Load(volatile uint32_t *p) {
+	uint32_t v;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		v = *p;
+	}
+	return v;
+}
+
+static void Store(volatile uint32_t *p, uint32_t v) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*p = v;
+	}
+}
+
+static bool Swap(volatile uint32_t *p, uint32_t expected, uint32_t v) {
+	bool ok;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ok = *p == expected;
+		if (ok) {
+			*p = v;
+		}
+	}
+	return ok;
+}
+
+static void Add(volatile uint32_t *p, uint32_t v) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*p += v;
+	}
+}
+
+static uint8_t Load8(volatile uint8_t *p) {
+	return *p;
+}
+
+static void Store8(volatile uint8_t *p, uint8_t v) {
+	*p = v;
+}
+
+#else
+
+static uint32_t Load(volatile uint32_t *p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void Store(volatile uint32_t *p, uint32_t v) {
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static bool Swap(volatile uint32_t *p, uint32_t expected, uint32_t v) {
+	return __atomic_compare_exchange_n(p, &expected, v, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static void Add(volatile uint32_t *p, uint32_t v) {
+	__atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+
+static uint8_t Load8(volatile uint8_t *p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void Store8(volatile uint8_t *p, uint8_t v) {
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+#endif
+
+EBYTE_E220_Owner::EBYTE_E220_Owner(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_tail = 0;
+	_head = 0;
+	_running = false;
+	_commands = 0;
+	_rejected = 0;
+
+	for (uint32_t i = 0; i < EBYTE_OWNER_SLOTS; i++) {
+		_slots[i].Seq = i;
+	}
+}
+
+/*
+method to claim the next free slot, a slot is free when its sequence number equals the position
+it is claimed for. if another task got there first the compare and swap fails and we try the next
+*/
+
+EBYTE_E220_Owner::Slot *EBYTE_E220_Owner::Claim() {
+
+	uint32_t pos = Load(&_tail);
+
+	for (;;) {
+
+		Slot *s = &_slots[pos % EBYTE_OWNER_SLOTS];
+		int32_t dif = (int32_t) (Load(&s->Seq) - pos);
+
+		if (dif == 0) {
+			if (Swap(&_tail, pos, pos + 1)) {
+				return s;
+			}
+		}
+		else if (dif < 0) {
+			// still holds a command from a lap ago, queue full
+			Add(&_rejected, 1);
+			return NULL;
+		}
+
+		pos = Load(&_tail);
+	}
+}
+
+/*
+method to hand a filled slot to the owner
+*/
+
+void EBYTE_E220_Owner::Publish(Slot *s, EBYTE_Future *future) {
+
+	s->Future = future;
+
+	if (future) {
+		Store8(&future->Status, EBYTE_OP_BUSY);
+	}
+
+	// Seq is the position + 1 now, the owner takes it when its head gets there
+	Store(&s->Seq, s->Seq + 1);
+}
+
+bool EBYTE_E220_Owner::setMode(uint8_t mode, EBYTE_Future *future) {
+
+	Slot *s = Claim();
+
+	if (s == NULL) {
+		return false;
+	}
+
+	s->Command = OWNER_MODE;
+	s->Mode = mode;
+	Publish(s, future);
+
+	return true;
+}
+
+/*
+method to write count registers from start, values are the new contents of just those registers
+*/
+
+bool EBYTE_E220_Owner::save(uint8_t start, uint8_t count, const uint8_t *values, uint8_t val, EBYTE_Future *future) {
+
+	if ((start + count) > 8 || count == 0) {
+		return false;
+	}
+
+	Slot *s = Claim();
+
+	if (s == NULL) {
+		return false;
+	}
+
+	s->Command = OWNER_SAVE;
+	s->Start = start;
+	s->Count = count;
+	s->Val = val;
+	memcpy(s->Data, values, count);
+	Publish(s, future);
+
+	return true;
+}
+
+bool EBYTE_E220_Owner::read(EBYTE_Future *future) {
+
+	Slot *s = Claim();
+
+	if (s == NULL) {
+		return false;
+	}
+
+	s->Command = OWNER_READ;
+	Publish(s, future);
+
+	return true;
+}
+
+bool EBYTE_E220_Owner::send(uint8_t type, const uint8_t *data, uint8_t len, EBYTE_Future *future) {
+
+	if (len > EBYTE_OWNER_PAYLOAD) {
+		return false;
+	}
+
+	Slot *s = Claim();
+
+	if (s == NULL) {
+		return false;
+	}
+
+	s->Command = OWNER_SEND;
+	s->Type = type;
+	s->Len = len;
+	memcpy(s->Data, data, len);
+	Publish(s, future);
+
+	return true;
+}
+
+bool EBYTE_E220_Owner::send(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len, EBYTE_Future *future) {
+
+	if (len > EBYTE_OWNER_PAYLOAD) {
+		return false;
+	}
+
+	Slot *s = Claim();
+
+	if (s == NULL) {
+		return false;
+	}
+
+	s->Command = OWNER_SEND_FIXED;
+	s->Address = address;
+	s->Channel = channel;
+	s->Type = type;
+	s->Len = len;
+	memcpy(s->Data, data, len);
+	Publish(s, future);
+
+	return true;
+}
+
+bool EBYTE_E220_Owner::ready(EBYTE_Future *future) {
+	return Load8(&future->Status) != EBYTE_OP_BUSY;
+}
+
+/*
+method to run the queue, one command at a time, and receive when there's none
+a command stays in its slot while it runs, so nothing is copied out
+*/
+
+void EBYTE_E220_Owner::service() {
+
+	Slot *s = &_slots[_head % EBYTE_OWNER_SLOTS];
+
+	if (!_running) {
+
+		if ((int32_t) (Load(&s->Seq) - (_head + 1)) != 0) {
+			// nothing published
+			if (_receiver) {
+				_receiver->service();
+			}
+			return;
+		}
+
+		if (s->Command == OWNER_SEND || s->Command == OWNER_SEND_FIXED) {
+
+			// sends wait here for the module instead of in sendFrame()
+			if (!_radio->getAux()) {
+				if (_receiver) {
+					_receiver->service();
+				}
+				return;
+			}
+
+			bool ok;
+
+			if (s->Command == OWNER_SEND) {
+				ok = _radio->sendFrame(s->Type, s->Data, s->Len);
+			}
+			else {
+				ok = _radio->sendFrame(s->Address, s->Channel, s->Type, s->Data, s->Len);
+			}
+
+			Complete(s, ok ? EBYTE_OP_DONE : EBYTE_OP_FAILED);
+			return;
+		}
+
+		if (!Start(s)) {
+			Complete(s, EBYTE_OP_FAILED);
+			return;
+		}
+
+		_running = true;
+	}
+
+	uint8_t status = _radio->poll();
+
+	if (status != EBYTE_OP_BUSY) {
+		_running = false;
+		Complete(s, status);
+	}
+}
+
+bool EBYTE_E220_Owner::Start(Slot *s) {
+
+	if (s->Command == OWNER_MODE) {
+		return _radio->startMode(s->Mode);
+	}
+
+	if (s->Command == OWNER_SAVE) {
+
+		uint8_t image[8];
+
+		_radio->getRegisters(image);
+		memcpy(image + s->Start, s->Data, s->Count);
+		_radio->setRegisters(image);
+
+		return _radio->startSave(s->Start, s->Count, s->Val);
+	}
+
+	return _radio->startRead();
+}
+
+/*
+method to report a command's result and give its slot back for position + EBYTE_OWNER_SLOTS
+*/
+
+void EBYTE_E220_Owner::Complete(Slot *s, uint8_t status) {
+
+	EBYTE_Future *future = s->Future;
+
+	_commands++;
+
+	Store(&s->Seq, _head + EBYTE_OWNER_SLOTS);
+	_head++;
+
+	if (future) {
+
+		// the waiting task may reuse the future as soon as it sees the status
+		EBYTE_FutureHandler handler = future->Handler;
+		void *ctx = future->Ctx;
+
+		_radio->getRegisters(future->Registers);
+		Store8(&future->Status, status);
+
+		if (handler) {
+			handler(future, ctx);
+		}
+	}
+}
+
+uint8_t EBYTE_E220_Owner::pending() {
+	return Load(&_tail) - _head;
+}
+
+uint32_t EBYTE_E220_Owner::getCommands() {
+	return _commands;
+}
+
+uint32_t EBYTE_E220_Owner::getRejected() {
+	return Load(&_rejected);
+}
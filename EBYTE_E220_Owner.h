@@ -0,0 +1,161 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  One task owns the module, the others ask it
+
+  Mode changes and register writes take over the UART and use the library's shared buffers, so
+  a task retuning the module while another sends (two cores on an ESP32, threads on a host) will
+  corrupt both. With EBYTE_E220_Owner only one task, the owner, ever touches the EBYTE_E220 and its
+  receiver. Other tasks put commands (mode change, register write, register read, send) in a queue
+  and the owner runs them one at a time from service(), between receiving.
+
+  Putting a command in the queue doesn't lock anything. Each slot has a sequence number, a task
+  claims the next free slot with a compare and swap on the tail and publishes the slot by storing
+  its sequence number (Vyukov's bounded queue, with one consumer). This uses the GCC __atomic
+  builtins on 32 bit MCUs and hosts, and on AVR, which has no compare and swap, interrupts are
+  off for the few instructions involved. So commands can also come from an interrupt.
+
+  Each command can have a future, which holds the result and the registers after the command.
+  Check it with ready(), or give it a handler which the owner calls when the command is done
+  (give a semaphore or notify a task from it, so the waiting task doesn't spin).
+
+  EBYTE_E220_Owner Owner(&Transceiver, &Receiver);
+
+  // owner task
+  for (;;) {
+	Owner.service();
+  }
+
+  // any other task
+  EBYTE_Future Retuned;
+  uint8_t channel = 20;
+  Owner.save(4, 1, &channel, EBYTE_WRITE_TEMPORARY, &Retuned);
+  ...
+  if (EBYTE_E220_Owner::ready(&Retuned) && Retuned.Status == EBYTE_OP_DONE) {
+	...
+  }
+
+  A future must stay put until it is ready, and can't be in the queue twice
+*/
+
+#ifndef EBYTE_E220_OWNER_H_LIB
+#define EBYTE_E220_OWNER_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// queue slots, must be a power of 2
+#ifndef EBYTE_OWNER_SLOTS
+#define EBYTE_OWNER_SLOTS 8
+#endif
+
+// largest frame that can be sent through the owner, each slot holds one
+#ifndef EBYTE_OWNER_PAYLOAD
+#if defined(__AVR__)
+#define EBYTE_OWNER_PAYLOAD 32
+#else
+#define EBYTE_OWNER_PAYLOAD EBYTE_FRAME_MAX
+#endif
+#endif
+
+struct EBYTE_Future;
+
+// called by the owner task when a command is done
+typedef void (*EBYTE_FutureHandler)(EBYTE_Future *future, void *ctx);
+
+struct EBYTE_Future {
+
+	EBYTE_Future(EBYTE_FutureHandler handler = NULL, void *ctx = NULL) {
+		Status = EBYTE_OP_IDLE;
+		Handler = handler;
+		Ctx = ctx;
+	}
+
+	volatile uint8_t Status;		// EBYTE_OP_BUSY until done, then EBYTE_OP_DONE or EBYTE_OP_FAILED
+	uint8_t Registers[8];			// ADDH to CRYPT_L after the command
+	EBYTE_FutureHandler Handler;
+	void *Ctx;
+};
+
+class EBYTE_E220_Owner {
+
+public:
+
+	EBYTE_E220_Owner(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver = NULL);
+
+	// from any task, core or interrupt, false if the queue is full, future can be NULL
+	bool setMode(uint8_t mode, EBYTE_Future *future = NULL);
+	bool save(uint8_t start, uint8_t count, const uint8_t *values, uint8_t val = EBYTE_WRITE_TEMPORARY, EBYTE_Future *future = NULL);
+	bool read(EBYTE_Future *future);
+	bool send(uint8_t type, const uint8_t *data, uint8_t len, EBYTE_Future *future = NULL);
+	bool send(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len, EBYTE_Future *future = NULL);
+
+	// true once the command is done and Status and Registers can be read
+	static bool ready(EBYTE_Future *future);
+
+	// owner task only
+	void service();
+	uint8_t pending();
+
+	uint32_t getCommands();
+	uint32_t getRejected();		// queue full
+
+private:
+
+	struct Slot {
+		volatile uint32_t Seq;
+		uint8_t Command;
+		uint8_t Mode;
+		uint8_t Start;
+		uint8_t Count;
+		uint8_t Val;
+		uint16_t Address;
+		uint8_t Channel;
+		uint8_t Type;
+		uint8_t Len;
+		uint8_t Data[EBYTE_OWNER_PAYLOAD];
+		EBYTE_Future *Future;
+	};
+
+	Slot *Claim();
+	void Publish(Slot *s, EBYTE_Future *future);
+	bool Start(Slot *s);
+	void Complete(Slot *s, uint8_t status);
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	Slot _slots[EBYTE_OWNER_SLOTS];
+	volatile uint32_t _tail;		// next slot to claim, any task
+	uint32_t _head;					// next slot to run, owner only
+	bool _running;
+
+	uint32_t _commands;
+	volatile uint32_t _rejected;
+
+};
+
+#endif
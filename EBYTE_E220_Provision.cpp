@@ -0,0 +1,255 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Provision.h>
+
+// where each module is
+#define PROV_READ 0
+#define PROV_WRITE 1
+#define PROV_VERIFY 2
+#define PROV_DONE 3
+
+static const char *ResultName[] = {"PENDING", "OK", "NO MODULE", "WRITE FAILED", "VERIFY FAILED", "MISMATCH"};
+
+EBYTE_E220_Provision::EBYTE_E220_Provision(EBYTE_E220_Manager *manager) {
+
+	_manager = manager;
+	_units = NULL;
+	_count = 0;
+	_left = 0;
+	_start = 0;
+}
+
+/*
+method to read a manifest line, numbers can be decimal or 0x hex, separated by commas or spaces
+*/
+
+bool EBYTE_E220_Provision::parse(const char *line, EBYTE_Unit *unit, uint16_t number) {
+
+	unsigned long val[5];
+	char *end;
+	uint8_t n = 0;
+
+	while (*line == ' ' || *line == '\t') {
+		line++;
+	}
+
+	if (*line == '#' || *line == '\0' || *line == '\r' || *line == '\n') {
+		return false;
+	}
+
+	while (n < 5) {
+		val[n] = strtoul(line, &end, 0);
+		if (end == line) {
+			return false;
+		}
+		n++;
+		line = end;
+		while (*line == ',' || *line == ' ' || *line == '\t') {
+			line++;
+		}
+	}
+
+	if (val[0] > 0xFFFF || val[1] > 83 || val[2] > 0xFFFF || val[4] > 3) {
+		return false;
+	}
+
+	memset(unit, 0, sizeof(EBYTE_Unit));
+	unit->Line = number;
+	unit->Address = val[0];
+	unit->Channel = val[1];
+	unit->Key = val[2];
+	unit->Power = val[4];
+
+	// ADR_2400_1 and ADR_2400_2 are the same rate as ADR_2400
+	for (uint8_t adr = ADR_2400; adr <= ADR_62500; adr++) {
+		if (EBYTE_AirDataRate(adr) == val[3]) {
+			unit->AirDataRate = adr;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool EBYTE_E220_Provision::begin(EBYTE_Unit *units, uint8_t count) {
+
+	if (count > _manager->getCount() || _manager->busy()) {
+		return false;
+	}
+
+	_units = units;
+	_count = count;
+	_left = count;
+	_start = millis();
+
+	_manager->onDone(DoneHandler, this);
+
+	for (uint8_t i = 0; i < count; i++) {
+		_units[i].Result = EBYTE_PROV_PENDING;
+		_units[i].Mismatch = 0;
+		_step[i] = PROV_READ;
+		_manager->read(i);
+	}
+
+	return true;
+}
+
+void EBYTE_E220_Provision::service() {
+	_manager->service();
+}
+
+bool EBYTE_E220_Provision::done() {
+	return _left == 0;
+}
+
+void EBYTE_E220_Provision::DoneHandler(uint8_t module, uint8_t status, void *ctx) {
+	((EBYTE_E220_Provision *) ctx)->Done(module, status);
+}
+
+/*
+method to take a module on to its next step once the manager is through with the last one
+*/
+
+void EBYTE_E220_Provision::Done(uint8_t module, uint8_t status) {
+
+	if (module >= _count || _step[module] == PROV_DONE) {
+		return;
+	}
+
+	EBYTE_Unit *u = &_units[module];
+	EBYTE_E220 *radio = _manager->getModule(module);
+	uint8_t image[8];
+
+	if (_step[module] == PROV_READ) {
+
+		if (status != EBYTE_OP_DONE) {
+			Finish(module, EBYTE_PROV_NO_MODULE);
+			return;
+		}
+
+		radio->setAddress(u->Address);
+		radio->setChannel(u->Channel);
+		radio->setEncryptonH(u->Key >> 8);
+		radio->setEncryptonL(u->Key & 0xFF);
+		radio->setAirDataRate(u->AirDataRate);
+		radio->setTransmitPower(u->Power);
+
+		radio->getRegisters(image);
+		memcpy(u->Wrote, image, EBYTE_PROV_VERIFY);
+
+		_step[module] = PROV_WRITE;
+		_manager->save(module, 0, 8, EBYTE_WRITE_PERMANENT);
+	}
+	else if (_step[module] == PROV_WRITE) {
+
+		if (status != EBYTE_OP_DONE) {
+			Finish(module, EBYTE_PROV_WRITE_FAILED);
+			return;
+		}
+
+		_step[module] = PROV_VERIFY;
+		_manager->read(module);
+	}
+	else {
+
+		if (status != EBYTE_OP_DONE) {
+			Finish(module, EBYTE_PROV_VERIFY_FAILED);
+			return;
+		}
+
+		radio->getRegisters(image);
+		memcpy(u->Read, image, EBYTE_PROV_VERIFY);
+
+		for (uint8_t i = 0; i < EBYTE_PROV_VERIFY; i++) {
+			if (u->Read[i] != u->Wrote[i]) {
+				u->Mismatch |= 1 << i;
+			}
+		}
+
+		Finish(module, u->Mismatch ? EBYTE_PROV_MISMATCH : EBYTE_PROV_OK);
+	}
+}
+
+void EBYTE_E220_Provision::Finish(uint8_t module, uint8_t result) {
+
+	_units[module].Result = result;
+	_units[module].Time = millis() - _start;
+	_step[module] = PROV_DONE;
+	_left--;
+}
+
+uint8_t EBYTE_E220_Provision::getPassed() {
+
+	uint8_t n = 0;
+
+	for (uint8_t i = 0; i < _count; i++) {
+		if (_units[i].Result == EBYTE_PROV_OK) {
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/*
+method to print a line per unit, starting with its manifest line and the module it was on.
+registers that read back wrong are listed as register:written/read in hex
+*/
+
+void EBYTE_E220_Provision::printReport(Print *p) {
+
+	p->println(F("line module address channel key rate power result ms"));
+
+	for (uint8_t i = 0; i < _count; i++) {
+
+		EBYTE_Unit *u = &_units[i];
+
+		p->print(u->Line);
+		p->print(F(" "));
+		p->print(i);
+		p->print(F(" 0x"));
+		p->print(u->Address, HEX);
+		p->print(F(" "));
+		p->print(u->Channel);
+		p->print(F(" 0x"));
+		p->print(u->Key, HEX);
+		p->print(F(" "));
+		p->print(EBYTE_AirDataRate(u->AirDataRate));
+		p->print(F(" "));
+		p->print(u->Power);
+		p->print(F(" "));
+		p->print(ResultName[u->Result]);
+		p->print(F(" "));
+		p->print(u->Time);
+
+		for (uint8_t r = 0; r < EBYTE_PROV_VERIFY; r++) {
+			if (u->Mismatch & (1 << r)) {
+				p->print(F(" "));
+				p->print(r);
+				p->print(F(":"));
+				p->print(u->Wrote[r], HEX);
+				p->print(F("/"));
+				p->print(u->Read[r], HEX);
+			}
+		}
+
+		p->println();
+	}
+}
@@ -0,0 +1,117 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Bulk provisioning for the EBYTE_E220 library
+
+  Programs a batch of modules at once, one per module owned by an EBYTE_E220_Manager, from a
+  manifest with one line per unit:
+
+  # address, channel, key, air data rate (bps), transmit power (TRP_xxx code)
+  0x0101, 10, 0xBEEF, 2400, 0
+
+  Each module has its registers read (so settings not in the manifest are kept), gets the unit's
+  settings written permanently, then is read back and compared. The key can't be read back (the
+  module returns 0), so the first 6 registers are compared. printReport() prints a line per unit,
+  starting with the manifest line number given to parse() so every batch traces back to the file.
+
+  EBYTE_E220_Provision Provision(&Manager);
+
+  EBYTE_Unit Units[4];
+  Provision.parse("0x0101,10,0xBEEF,2400,0", &Units[0], 1);	// manifest line 1
+  ...
+  Provision.begin(Units, 4);			// unit i goes on module i
+  while (!Provision.done()) {
+	Provision.service();
+  }
+  Provision.printReport(&Serial);
+
+  The provisioner uses the manager's onDone() handler while it runs
+*/
+
+#ifndef EBYTE_E220_PROVISION_H_LIB
+#define EBYTE_E220_PROVISION_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Manager.h"
+
+// result for each unit
+#define EBYTE_PROV_PENDING 0
+#define EBYTE_PROV_OK 1
+#define EBYTE_PROV_NO_MODULE 2			// first read got no answer
+#define EBYTE_PROV_WRITE_FAILED 3		// register write not acknowledged
+#define EBYTE_PROV_VERIFY_FAILED 4		// read back got no answer
+#define EBYTE_PROV_MISMATCH 5			// read back differs, see Mismatch
+
+// registers compared on read back, ADDH to REG3
+#define EBYTE_PROV_VERIFY 6
+
+struct EBYTE_Unit {
+	uint16_t Line;				// manifest line number, 0 if none was given
+	uint16_t Address;
+	uint8_t Channel;
+	uint16_t Key;
+	uint8_t AirDataRate;		// ADR_xxx
+	uint8_t Power;				// TRP_xxx
+	uint8_t Result;
+	uint8_t Mismatch;			// bit n set, register n read back wrong
+	uint8_t Wrote[EBYTE_PROV_VERIFY];
+	uint8_t Read[EBYTE_PROV_VERIFY];
+	unsigned long Time;			// ms from begin() to the unit's result
+};
+
+class EBYTE_E220_Provision {
+
+public:
+
+	EBYTE_E220_Provision(EBYTE_E220_Manager *manager);
+
+	// one manifest line, false for blank lines, comments and lines that don't parse. number is
+	// where the line is in the manifest, the report prints it
+	static bool parse(const char *line, EBYTE_Unit *unit, uint16_t number = 0);
+
+	bool begin(EBYTE_Unit *units, uint8_t count);
+	void service();
+	bool done();
+
+	uint8_t getPassed();
+	void printReport(Print *p);
+
+private:
+
+	static void DoneHandler(uint8_t module, uint8_t status, void *ctx);
+	void Done(uint8_t module, uint8_t status);
+	void Finish(uint8_t module, uint8_t result);
+
+	EBYTE_E220_Manager *_manager;
+	EBYTE_Unit *_units;
+	uint8_t _count;
+	uint8_t _left;
+	uint8_t _step[EBYTE_MANAGER_MODULES];
+	unsigned long _start;
+
+};
+
+#endif
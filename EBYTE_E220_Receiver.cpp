@@ -0,0 +1,297 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Receiver.h>
+
+// parser states
+#define RX_SYNC 0
+#define RX_LEN 1
+#define RX_TYPE 2
+#define RX_DATA 3
+#define RX_CRC 4
+#define RX_RSSI 5
+
+EBYTE_E220_Receiver::EBYTE_E220_Receiver(Stream *s) {
+
+	_s = s;
+	_head = 0;
+	_tail = 0;
+	_paused = false;
+	_handlerCount = 0;
+	_container = EBYTE_FRAME_ANY;
+	_state = RX_SYNC;
+	_len = 0;
+	_type = 0;
+	_pos = 0;
+	_crc = 0;
+	_frameSize = 0;
+	_rssi = false;
+	_rssiByte = 0;
+	_lastByte = 0;
+	_frames = 0;
+	_errors = 0;
+	_overruns = 0;
+}
+
+void EBYTE_E220_Receiver::setFrameSize(uint8_t size) {
+
+	_frameSize = min(size, (uint8_t) EBYTE_FRAME_MAX);
+	_state = _frameSize ? RX_DATA : RX_SYNC;
+	_pos = 0;
+}
+
+void EBYTE_E220_Receiver::setRSSI(bool val) {
+	_rssi = val;
+}
+
+bool EBYTE_E220_Receiver::onFrame(EBYTE_FrameHandler handler, void *ctx, uint8_t type) {
+
+	// the same handler for the same frames again is already there
+	for (uint8_t i = 0; i < _handlerCount; i++) {
+		if (_handlers[i].Func == handler && _handlers[i].Ctx == ctx && _handlers[i].Type == type) {
+			return true;
+		}
+	}
+
+	if (_handlerCount >= EBYTE_MAX_HANDLERS) {
+		EBYTE_LOGE(EBYTE_ERR_HANDLERS_FULL, type);
+		return false;
+	}
+
+	_handlers[_handlerCount].Func = handler;
+	_handlers[_handlerCount].Ctx = ctx;
+	_handlers[_handlerCount].Type = type;
+	_handlerCount++;
+
+	return true;
+}
+
+void EBYTE_E220_Receiver::clearHandlers() {
+	_handlerCount = 0;
+	_container = EBYTE_FRAME_ANY;
+}
+
+void EBYTE_E220_Receiver::setContainer(uint8_t type) {
+	_container = type;
+}
+
+/*
+move everything the serial port has into the ring, in as few readBytes() calls as possible
+if the ring is full the rest stays in the serial buffer (counted as an overrun)
+*/
+
+uint16_t EBYTE_E220_Receiver::drain() {
+
+	uint16_t moved = 0;
+
+	if (_paused) {
+		return 0;
+	}
+
+	int avail = _s->available();
+
+	while (avail > 0) {
+
+		uint8_t head = _head;
+		uint8_t free = (uint8_t) (head - _tail - 1);
+
+		if (free == 0) {
+			_overruns++;
+			break;
+		}
+
+		// contiguous space up to the end of the ring or the consumer's position
+		uint16_t chunk = (head > _tail) ? free : 256 - _tail - (head == 0 ? 1 : 0);
+		chunk = min(chunk, (uint16_t) avail);
+
+		chunk = _s->readBytes(&_ring[_tail], chunk);
+		if (chunk == 0) {
+			break;
+		}
+
+		_tail += chunk;
+		moved += chunk;
+		avail -= chunk;
+	}
+
+	return moved;
+}
+
+bool EBYTE_E220_Receiver::Take(uint8_t *c) {
+
+	if (_head == _tail) {
+		return false;
+	}
+
+	*c = _ring[_head];
+	_head++;
+
+	return true;
+}
+
+/*
+run the frame parser over everything in the ring
+*/
+
+uint8_t EBYTE_E220_Receiver::dispatch() {
+
+	uint8_t count = 0;
+	uint8_t c;
+
+	// a frame that stalls part way is abandoned so we resync on the next one
+	if ((_pos || _state != (_frameSize ? RX_DATA : RX_SYNC)) && (millis() - _lastByte) > EBYTE_FRAME_TIMEOUT) {
+		_errors++;
+		_state = _frameSize ? RX_DATA : RX_SYNC;
+		_pos = 0;
+	}
+
+	while (Take(&c)) {
+
+		_lastByte = millis();
+
+		switch (_state) {
+
+			case RX_SYNC:
+				if (c == EBYTE_FRAME_SYNC) {
+					_state = RX_LEN;
+				}
+				break;
+
+			case RX_LEN:
+				if (c > EBYTE_FRAME_MAX) {
+					_errors++;
+					_state = RX_SYNC;
+					break;
+				}
+				_len = c;
+				_crc = EBYTE_CRC8(&c, 1);
+				_state = RX_TYPE;
+				break;
+
+			case RX_TYPE:
+				_type = c;
+				_crc = EBYTE_CRC8(&c, 1, _crc);
+				_pos = 0;
+				_state = _len ? RX_DATA : RX_CRC;
+				break;
+
+			case RX_DATA:
+				_frame[_pos++] = c;
+				if (_frameSize) {
+					if (_pos == _frameSize) {
+						_type = EBYTE_FRAME_RAW;
+						_len = _frameSize;
+						if (_rssi) {
+							_state = RX_RSSI;
+						}
+						else {
+							Deliver();
+							count++;
+						}
+					}
+					break;
+				}
+				if (_pos == _len) {
+					_crc = EBYTE_CRC8(_frame, _len, _crc);
+					_state = RX_CRC;
+				}
+				break;
+
+			case RX_CRC:
+				if (c != _crc) {
+					_errors++;
+					_state = RX_SYNC;
+					break;
+				}
+				if (_rssi) {
+					_state = RX_RSSI;
+					break;
+				}
+				Deliver();
+				count++;
+				break;
+
+			case RX_RSSI:
+				_rssiByte = c;
+				Deliver();
+				count++;
+				break;
+		}
+	}
+
+	return count;
+}
+
+void EBYTE_E220_Receiver::Deliver() {
+
+	int16_t rssi = _rssi ? -(256 - (int16_t) _rssiByte) : -999;
+
+	_frames++;
+
+	deliver(_type, _frame, _len, rssi);
+
+	_state = _frameSize ? RX_DATA : RX_SYNC;
+	_pos = 0;
+}
+
+void EBYTE_E220_Receiver::deliver(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi) {
+
+	// a container comes back through here a record at a time, EBYTE_FRAME_ANY handlers get the
+	// records and not the container as well
+	bool any = type != _container;
+
+	for (uint8_t i = 0; i < _handlerCount; i++) {
+		if ((_handlers[i].Type == EBYTE_FRAME_ANY && any) || _handlers[i].Type == type) {
+			_handlers[i].Func(type, data, len, rssi, _handlers[i].Ctx);
+		}
+	}
+}
+
+uint8_t EBYTE_E220_Receiver::service() {
+	drain();
+	return dispatch();
+}
+
+void EBYTE_E220_Receiver::pause(bool val) {
+	_paused = val;
+}
+
+bool EBYTE_E220_Receiver::isPaused() {
+	return _paused;
+}
+
+bool EBYTE_E220_Receiver::idle() {
+	return _head == _tail && _pos == 0 && _state == (_frameSize ? RX_DATA : RX_SYNC) && _s->available() == 0;
+}
+
+uint8_t EBYTE_E220_Receiver::available() {
+	return (uint8_t) (_tail - _head);
+}
+
+uint32_t EBYTE_E220_Receiver::getFrames() {
+	return _frames;
+}
+
+uint32_t EBYTE_E220_Receiver::getErrors() {
+	return _errors;
+}
+
+uint32_t EBYTE_E220_Receiver::getOverruns() {
+	return _overruns;
+}
@@ -0,0 +1,160 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Event driven receiver for the EBYTE_E220 library
+
+  Instead of polling ESerial.available() and blocking in readBytes(), the receiver moves whatever is in
+  the serial buffer into its own ring buffer in one go, finds complete frames and calls the handlers
+  you registered. Attach it to the EBYTE_E220 object and data received while the library changes modes
+  or reads RSSI is kept instead of being flushed.
+
+  EBYTE_E220_Receiver Receiver(&ESerial);
+
+  Transceiver.attachReceiver(&Receiver);
+  Receiver.onFrame(GotData, NULL);
+  ...
+  void loop() {
+    Receiver.service();
+  }
+
+  Frames are what EBYTE_E220::sendFrame() sends. If the sender writes plain structs call
+  setFrameSize(sizeof(MyData)) and each handler call gets one struct (type EBYTE_FRAME_RAW).
+
+  drain() and dispatch() can also be called separately, for example drain() from serialEvent() and
+  dispatch() from loop(). The ring buffer is single producer (drain) single consumer (dispatch) and
+  needs no locking as each side only writes its own index
+*/
+
+#ifndef EBYTE_E220_RECEIVER_H_LIB
+#define EBYTE_E220_RECEIVER_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+
+// number of handlers that can be registered, each layer's begin() takes one (ARQ takes two)
+// it sets the size of EBYTE_E220_Receiver, so change it with a build flag that the library sees too
+#ifndef EBYTE_MAX_HANDLERS
+#define EBYTE_MAX_HANDLERS 12
+#endif
+
+// a frame that stops arriving part way is dropped after this long (ms)
+#define EBYTE_FRAME_TIMEOUT 1000
+
+// handler types, pass to onFrame() to get every frame
+#define EBYTE_FRAME_ANY 0xFE
+
+// called for each complete frame, rssi is -999 unless RSSI bytes are enabled
+// data may be changed in place by the handler (it's the receiver's buffer and is reused after the call)
+typedef void (*EBYTE_FrameHandler)(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+
+class EBYTE_E220_Receiver {
+
+public:
+
+	EBYTE_E220_Receiver(Stream *s);
+
+	// methods to set up framing
+	void setFrameSize(uint8_t size = 0);	// 0 = frames from sendFrame(), else fixed size structs
+	void setRSSI(bool val);					// expect an RSSI byte after each frame (setRSSISignalStrength(true))
+
+	// methods to register handlers, type EBYTE_FRAME_ANY gets all frames but the container type
+	// registering the same handler, ctx and type again does nothing, false if the table is full
+	bool onFrame(EBYTE_FrameHandler handler, void *ctx, uint8_t type = EBYTE_FRAME_ANY);
+	void clearHandlers();
+
+	// frames of this type are unpacked and what's in them delivered again, so EBYTE_FRAME_ANY
+	// handlers skip them (EBYTE_E220_Unbatcher sets EBYTE_FRAME_BATCH), EBYTE_FRAME_ANY for none.
+	// handlers registered for the type itself still get them
+	void setContainer(uint8_t type);
+
+	// producer, move bytes from the serial port into the ring buffer, returns bytes moved
+	uint16_t drain();
+
+	// consumer, find frames and call the handlers, returns frames handled
+	uint8_t dispatch();
+
+	// both
+	uint8_t service();
+
+	// while paused drain() leaves the serial port alone, EBYTE_E220 pauses its receiver while
+	// startMode() / startSave() / startRead() have the module in program mode
+	void pause(bool val);
+	bool isPaused();
+
+	// hand a frame rebuilt by another layer (see EBYTE_E220_Reassembler) to the handlers
+	void deliver(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi);
+
+	// true when nothing is waiting in the serial port or the ring and no frame is part way in
+	// the time to send the module a command that answers on the same port (readRSSIAmbientNoise())
+	bool idle();
+
+	// methods to get statistics
+	uint8_t available();
+	uint32_t getFrames();
+	uint32_t getErrors();
+	uint32_t getOverruns();
+
+private:
+
+	bool Take(uint8_t *c);
+	void Deliver();
+
+	Stream *_s;
+
+	// ring buffer, 256 bytes so the 8 bit indexes wrap on their own and are updated atomically on any MCU
+	uint8_t _ring[256];
+	volatile uint8_t _head;		// written by dispatch()
+	volatile uint8_t _tail;		// written by drain()
+	volatile bool _paused;
+
+	struct Handler {
+		EBYTE_FrameHandler Func;
+		void *Ctx;
+		uint8_t Type;
+	};
+
+	Handler _handlers[EBYTE_MAX_HANDLERS];
+	uint8_t _handlerCount;
+	uint8_t _container;		// type EBYTE_FRAME_ANY handlers skip
+
+	// frame being assembled
+	uint8_t _frame[EBYTE_FRAME_MAX];
+	uint8_t _state;
+	uint8_t _len;
+	uint8_t _type;
+	uint8_t _pos;
+	uint8_t _crc;
+	uint8_t _frameSize;
+	bool _rssi;
+	uint8_t _rssiByte;
+	unsigned long _lastByte;
+
+	uint32_t _frames;
+	uint32_t _errors;
+	uint32_t _overruns;
+
+};
+
+#endif
@@ -0,0 +1,417 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Relay.h>
+
+// header offsets
+#define RELAY_SOURCE 0
+#define RELAY_DEST 2
+#define RELAY_HOP 4
+#define RELAY_CHANNEL 6
+#define RELAY_SEQ 7
+#define RELAY_TTL 8
+#define RELAY_ELAPSED 9
+#define RELAY_TYPE 11
+
+static uint16_t Get16(const uint8_t *p) {
+	return ((uint16_t) p[0] << 8) | p[1];
+}
+
+static void Put16(uint8_t *p, uint16_t val) {
+	p[0] = val >> 8;
+	p[1] = val & 0xFF;
+}
+
+EBYTE_E220_Relay::EBYTE_E220_Relay(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_handler = NULL;
+	_ctx = NULL;
+	_routeCount = 0;
+	_hasDefault = false;
+	_learning = true;
+	_forward = true;
+	_address = 0;
+	_seq = 0;
+	_queued = 0;
+	_forwarded = 0;
+	_delivered = 0;
+	_duplicates = 0;
+	_expired = 0;
+	_congested = 0;
+	_maxQueue = 0;
+	_hopLatency = 0;
+
+	memset(_routes, 0, sizeof(_routes));
+	memset(&_default, 0, sizeof(_default));
+	memset(&_direct, 0, sizeof(_direct));
+	memset(_sources, 0, sizeof(_sources));
+}
+
+/*
+method to add a static route, learned routes never replace it
+*/
+
+bool EBYTE_E220_Relay::addRoute(uint16_t destination, uint16_t nextHop, uint8_t channel) {
+
+	uint8_t i;
+
+	for (i = 0; i < _routeCount; i++) {
+		if (_routes[i].Destination == destination) {
+			break;
+		}
+	}
+
+	if (i == _routeCount) {
+		if (_routeCount >= EBYTE_RELAY_ROUTES) {
+			return false;
+		}
+		_routeCount++;
+	}
+
+	_routes[i].Destination = destination;
+	_routes[i].NextHop = nextHop;
+	_routes[i].Channel = channel;
+	_routes[i].Learned = false;
+	_routes[i].Used = millis();
+
+	return true;
+}
+
+void EBYTE_E220_Relay::setDefaultRoute(uint16_t nextHop, uint8_t channel) {
+
+	_default.Destination = 0xFFFF;
+	_default.NextHop = nextHop;
+	_default.Channel = channel;
+	_hasDefault = true;
+}
+
+void EBYTE_E220_Relay::setLearning(bool val) {
+	_learning = val;
+}
+
+void EBYTE_E220_Relay::onReceive(EBYTE_RelayHandler handler, void *ctx) {
+	_handler = handler;
+	_ctx = ctx;
+}
+
+bool EBYTE_E220_Relay::begin(bool forward) {
+
+	_forward = forward;
+	_address = _radio->getAddress();
+
+	return _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_RELAY);
+}
+
+/*
+method to send a frame to any node, through as many relays as the routes take
+*/
+
+bool EBYTE_E220_Relay::send(uint16_t destination, uint8_t type, const uint8_t *data, uint8_t len) {
+
+	uint8_t frame[EBYTE_FRAME_MAX];
+
+	if (len > EBYTE_RELAY_PAYLOAD) {
+		return false;
+	}
+
+	Put16(&frame[RELAY_SOURCE], _address);
+	Put16(&frame[RELAY_DEST], destination);
+	Put16(&frame[RELAY_HOP], _address);
+	frame[RELAY_CHANNEL] = _radio->getChannel();
+	frame[RELAY_SEQ] = _seq++;
+	frame[RELAY_TTL] = EBYTE_RELAY_TTL;
+	Put16(&frame[RELAY_ELAPSED], 0);
+	frame[RELAY_TYPE] = type;
+	memcpy(&frame[EBYTE_RELAY_HEADER], data, len);
+
+	return Transmit(frame, EBYTE_RELAY_HEADER + len);
+}
+
+EBYTE_Route *EBYTE_E220_Relay::findRoute(uint16_t destination) {
+
+	for (uint8_t i = 0; i < _routeCount; i++) {
+		if (_routes[i].Destination == destination) {
+			_routes[i].Used = millis();
+			return &_routes[i];
+		}
+	}
+
+	if (_hasDefault) {
+		return &_default;
+	}
+
+	_direct.Destination = destination;
+	_direct.NextHop = destination;
+	_direct.Channel = _radio->getChannel();
+
+	return &_direct;
+}
+
+/*
+method to hand a frame to the module, frame is the receiver's buffer when forwarding
+the module sends what it's given back to back, so a frame waits for all the ones before it
+*/
+
+bool EBYTE_E220_Relay::Transmit(uint8_t *frame, uint8_t len) {
+
+	unsigned long now = millis();
+	unsigned long start = now;
+	unsigned long air;
+	uint8_t i, n = 0;
+
+	// drop what's on air by now
+	for (i = 0; i < _queued; i++) {
+		if ((long) (_finish[i] - now) > 0) {
+			_finish[n++] = _finish[i];
+		}
+	}
+	_queued = n;
+
+	if (_queued >= EBYTE_RELAY_QUEUE) {
+		_congested++;
+		return false;
+	}
+
+	if (_queued > 0) {
+		start = _finish[_queued - 1];
+	}
+
+	air = _radio->getAirTime(len + EBYTE_FRAME_OVERHEAD) / 1000;
+
+	_finish[_queued++] = start + air;
+
+	if (_queued > _maxQueue) {
+		_maxQueue = _queued;
+	}
+
+	// what this hop adds, waiting for the module and air time
+	uint16_t added = (start - now) + air;
+	uint32_t elapsed = Get16(&frame[RELAY_ELAPSED]) + added;
+
+	Put16(&frame[RELAY_ELAPSED], elapsed > 0xFFFF ? 0xFFFF : elapsed);
+
+	_hopLatency = _hopLatency == 0 ? added : (_hopLatency * 7 + added) / 8;
+
+	EBYTE_Route *route = findRoute(Get16(&frame[RELAY_DEST]));
+
+	return _radio->sendFrame(route->NextHop, route->Channel, EBYTE_FRAME_RELAY, frame, len);
+}
+
+void EBYTE_E220_Relay::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_Relay *) ctx)->GotFrame(data, len);
+}
+
+void EBYTE_E220_Relay::GotFrame(uint8_t *data, uint8_t len) {
+
+	if (len < EBYTE_RELAY_HEADER) {
+		return;
+	}
+
+	uint16_t source = Get16(&data[RELAY_SOURCE]);
+	uint16_t destination = Get16(&data[RELAY_DEST]);
+	uint16_t hop = Get16(&data[RELAY_HOP]);
+	uint8_t channel = data[RELAY_CHANNEL];
+
+	// our own frame coming back
+	if (source == _address) {
+		return;
+	}
+
+	if (_learning) {
+		Learn(hop, hop, channel);
+		if (source != hop) {
+			Learn(source, hop, channel);
+		}
+	}
+
+	if (Duplicate(source, data[RELAY_SEQ])) {
+		_duplicates++;
+		return;
+	}
+
+	if (destination == _address) {
+		_delivered++;
+		if (_handler) {
+			_handler(source, data[RELAY_TYPE], data + EBYTE_RELAY_HEADER, len - EBYTE_RELAY_HEADER,
+				EBYTE_RELAY_TTL - data[RELAY_TTL], Get16(&data[RELAY_ELAPSED]), _ctx);
+		}
+		return;
+	}
+
+	if (!_forward) {
+		return;
+	}
+
+	if (data[RELAY_TTL] <= 1) {
+		_expired++;
+		return;
+	}
+
+	// passed on from the receiver's buffer, only the header changes
+	data[RELAY_TTL]--;
+	Put16(&data[RELAY_HOP], _address);
+	data[RELAY_CHANNEL] = _radio->getChannel();
+
+	if (Transmit(data, len)) {
+		_forwarded++;
+	}
+}
+
+/*
+method to check a sequence number against the window of the last 32 from a source
+anything older than the window counts as seen, a source that restarts is picked up again
+once its numbers pass the window
+*/
+
+bool EBYTE_E220_Relay::Duplicate(uint16_t source, uint8_t seq) {
+
+	Source *s = NULL;
+	Source *oldest = &_sources[0];
+	unsigned long now = millis();
+	uint8_t i;
+
+	for (i = 0; i < EBYTE_RELAY_SOURCES; i++) {
+		if (_sources[i].Used != 0 && _sources[i].Address == source) {
+			s = &_sources[i];
+			break;
+		}
+		if (_sources[i].Used == 0 || (long) (_sources[i].Used - oldest->Used) < 0) {
+			oldest = &_sources[i];
+		}
+	}
+
+	if (s == NULL) {
+		s = oldest;
+		s->Address = source;
+		s->Used = 0;
+	}
+
+	int8_t ahead = (int8_t) (seq - s->Top);
+	uint8_t back = -ahead;
+
+	// new, quiet for a while or too far back to be a late copy, the source (re)started
+	if (s->Used == 0 || (long) (now - s->Used) >= EBYTE_RELAY_FORGET || (ahead <= 0 && back >= 32)) {
+		s->Top = seq;
+		s->Seen = 1;
+		s->Used = now | 1;
+		return false;
+	}
+
+	s->Used = now | 1;
+
+	if (ahead > 0) {
+		s->Seen = ahead >= 32 ? 1 : (s->Seen << ahead) | 1;
+		s->Top = seq;
+		return false;
+	}
+
+	if (s->Seen & ((uint32_t) 1 << back)) {
+		return true;
+	}
+
+	s->Seen |= (uint32_t) 1 << back;
+
+	return false;
+}
+
+/*
+method to remember the way back to a node, static routes stay, the least used learned one goes
+*/
+
+void EBYTE_E220_Relay::Learn(uint16_t destination, uint16_t nextHop, uint8_t channel) {
+
+	EBYTE_Route *r = NULL;
+	uint8_t i;
+
+	for (i = 0; i < _routeCount; i++) {
+		if (_routes[i].Destination == destination) {
+			if (!_routes[i].Learned) {
+				return;
+			}
+			r = &_routes[i];
+			break;
+		}
+	}
+
+	if (r == NULL) {
+		if (_routeCount < EBYTE_RELAY_ROUTES) {
+			r = &_routes[_routeCount++];
+		}
+		else {
+			for (i = 0; i < _routeCount; i++) {
+				if (_routes[i].Learned && (r == NULL || (long) (_routes[i].Used - r->Used) < 0)) {
+					r = &_routes[i];
+				}
+			}
+			if (r == NULL) {
+				return;
+			}
+		}
+	}
+
+	r->Destination = destination;
+	r->NextHop = nextHop;
+	r->Channel = channel;
+	r->Learned = true;
+	r->Used = millis();
+}
+
+uint32_t EBYTE_E220_Relay::getForwarded() {
+	return _forwarded;
+}
+
+uint32_t EBYTE_E220_Relay::getDelivered() {
+	return _delivered;
+}
+
+uint32_t EBYTE_E220_Relay::getDuplicates() {
+	return _duplicates;
+}
+
+uint32_t EBYTE_E220_Relay::getExpired() {
+	return _expired;
+}
+
+uint32_t EBYTE_E220_Relay::getCongested() {
+	return _congested;
+}
+
+uint8_t EBYTE_E220_Relay::getQueueDepth() {
+
+	unsigned long now = millis();
+	uint8_t n = 0;
+
+	for (uint8_t i = 0; i < _queued; i++) {
+		if ((long) (_finish[i] - now) > 0) {
+			n++;
+		}
+	}
+
+	return n;
+}
+
+uint8_t EBYTE_E220_Relay::getMaxQueueDepth() {
+	return _maxQueue;
+}
+
+uint16_t EBYTE_E220_Relay::getHopLatency() {
+	return _hopLatency;
+}
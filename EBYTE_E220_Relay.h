@@ -0,0 +1,183 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Multi-hop relay for the EBYTE_E220 library
+
+  When a site is out of range of one hop, nodes in between pass frames on. Every frame carries the
+  address it came from (source), where it's going (destination), the node that sent this hop and the
+  channel it listens on, a sequence number, a hop limit and the time it has spent on the way so far.
+  Each node looks the destination up in a small routing table (address -> next hop address and
+  channel) and sends it on with a fixed point transmission, which can go out on another channel
+  without retuning our module.
+
+  Routes are static (addRoute()) or learned, a frame from a source teaches us that the source can be
+  reached back through the node that just sent it, on that node's channel. With no route a frame goes
+  straight to the destination (or the default route if there is one).
+
+  Each node remembers the last 32 sequence numbers of the most recent sources in a bitmap, so a frame
+  that arrives twice (two relays in range, a retry) is passed on once. A source that has been quiet
+  for EBYTE_RELAY_FORGET ms, or whose sequence number jumps back past the bitmap, is taken to have
+  restarted and starts over. Frames are forwarded straight out of the receiver's buffer, the header
+  is changed in place and nothing is copied.
+
+  The module can only hold so much, so each node keeps track of when what it has handed the module
+  will be on air. Queue depth is how many frames are still waiting, and the time a frame waited plus
+  its air time is added to the frame, so the destination knows the latency of the whole path.
+
+  EBYTE_E220_Relay Relay(&Transceiver, &Receiver);
+
+  Relay.addRoute(0x0300, 0x0200, 20);			// 0x0300 is reached through 0x0200 on channel 20
+  Relay.onReceive(GotFrame, NULL);
+  Relay.begin();								// begin(false) for an end node that doesn't forward
+  ...
+  Relay.send(0x0300, EBYTE_FRAME_DATA, (uint8_t*) &MyData, sizeof(MyData));
+
+  All modules need TRM_FIXEDPOINT and their own address
+*/
+
+#ifndef EBYTE_E220_RELAY_H_LIB
+#define EBYTE_E220_RELAY_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// routing table entries
+#ifndef EBYTE_RELAY_ROUTES
+#define EBYTE_RELAY_ROUTES 16
+#endif
+
+// sources remembered for duplicate suppression
+#ifndef EBYTE_RELAY_SOURCES
+#define EBYTE_RELAY_SOURCES 8
+#endif
+
+// a source quiet for this long (ms) is forgotten, so one that restarts at sequence 0 isn't dropped
+#ifndef EBYTE_RELAY_FORGET
+#define EBYTE_RELAY_FORGET 5000
+#endif
+
+// frames handed to the module and not yet on air before new ones are dropped
+#define EBYTE_RELAY_QUEUE 4
+
+// hop limit for frames we send
+#define EBYTE_RELAY_TTL 8
+
+// header, source + destination + this hop and its channel + seq + hops left + elapsed ms + frame type
+#define EBYTE_RELAY_HEADER 12
+
+// largest payload
+#define EBYTE_RELAY_PAYLOAD (EBYTE_FRAME_MAX - EBYTE_RELAY_HEADER)
+
+// called for frames addressed to us, hops is the number of relays on the way, latency is the
+// waiting and air time added up along the path (ms)
+typedef void (*EBYTE_RelayHandler)(uint16_t source, uint8_t type, uint8_t *data, uint8_t len, uint8_t hops, uint16_t latency, void *ctx);
+
+struct EBYTE_Route {
+	uint16_t Destination;
+	uint16_t NextHop;
+	uint8_t Channel;
+	bool Learned;
+	unsigned long Used;
+};
+
+class EBYTE_E220_Relay {
+
+public:
+
+	EBYTE_E220_Relay(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	// static routes, before begin()
+	bool addRoute(uint16_t destination, uint16_t nextHop, uint8_t channel);
+	void setDefaultRoute(uint16_t nextHop, uint8_t channel);
+	void setLearning(bool val);
+
+	void onReceive(EBYTE_RelayHandler handler, void *ctx);
+
+	bool begin(bool forward = true);
+
+	bool send(uint16_t destination, uint8_t type, const uint8_t *data, uint8_t len);
+
+	// route used for a destination (direct on our channel if there's none)
+	EBYTE_Route *findRoute(uint16_t destination);
+
+	uint32_t getForwarded();
+	uint32_t getDelivered();
+	uint32_t getDuplicates();
+	uint32_t getExpired();			// hop limit reached
+	uint32_t getCongested();		// dropped, module queue full
+	uint8_t getQueueDepth();
+	uint8_t getMaxQueueDepth();
+	uint16_t getHopLatency();		// average ms a frame spends at this node and on air from it
+
+private:
+
+	struct Source {
+		uint16_t Address;
+		uint8_t Top;			// highest sequence seen
+		uint32_t Seen;			// bit i set, Top - i seen
+		unsigned long Used;
+	};
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotFrame(uint8_t *data, uint8_t len);
+	bool Duplicate(uint16_t source, uint8_t seq);
+	void Learn(uint16_t destination, uint16_t nextHop, uint8_t channel);
+	bool Transmit(uint8_t *frame, uint8_t len);
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	EBYTE_RelayHandler _handler;
+	void *_ctx;
+
+	EBYTE_Route _routes[EBYTE_RELAY_ROUTES];
+	uint8_t _routeCount;
+	EBYTE_Route _default;
+	bool _hasDefault;
+	EBYTE_Route _direct;
+	bool _learning;
+	bool _forward;
+
+	Source _sources[EBYTE_RELAY_SOURCES];
+
+	uint16_t _address;
+	uint8_t _seq;
+
+	// when each frame handed to the module will be done
+	unsigned long _finish[EBYTE_RELAY_QUEUE];
+	uint8_t _queued;
+
+	uint32_t _forwarded;
+	uint32_t _delivered;
+	uint32_t _duplicates;
+	uint32_t _expired;
+	uint32_t _congested;
+	uint8_t _maxQueue;
+	uint16_t _hopLatency;
+
+};
+
+#endif
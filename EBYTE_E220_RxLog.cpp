@@ -0,0 +1,294 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_RxLog.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+EBYTE_PrintSink::EBYTE_PrintSink(Print *p) {
+	_p = p;
+}
+
+bool EBYTE_PrintSink::write(const uint8_t *block, uint16_t len) {
+	return _p->write(block, len) == len;
+}
+
+#if defined(__linux__)
+
+EBYTE_MmapSink::EBYTE_MmapSink() {
+
+	_fd = -1;
+	_map = NULL;
+	_size = 0;
+	_pos = 0;
+}
+
+EBYTE_MmapSink::~EBYTE_MmapSink() {
+	close();
+}
+
+bool EBYTE_MmapSink::open(const char *path, size_t reserve) {
+
+	close();
+
+	_fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (_fd < 0) {
+		return false;
+	}
+
+	_pos = 0;
+
+	return Grow(reserve);
+}
+
+/*
+method to make the file (and the mapping) bigger, the old mapping goes and a new one is made
+*/
+
+bool EBYTE_MmapSink::Grow(size_t size) {
+
+	if (_map) {
+		munmap(_map, _size);
+		_map = NULL;
+	}
+
+	if (ftruncate(_fd, size) != 0) {
+		return false;
+	}
+
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+	if (map == MAP_FAILED) {
+		return false;
+	}
+
+	_map = (uint8_t *) map;
+	_size = size;
+
+	return true;
+}
+
+bool EBYTE_MmapSink::write(const uint8_t *block, uint16_t len) {
+
+	if (_fd < 0) {
+		return false;
+	}
+
+	if (_pos + len > _size && !Grow(_size * 2 > _pos + len ? _size * 2 : _pos + len)) {
+		return false;
+	}
+
+	memcpy(_map + _pos, block, len);
+	_pos += len;
+
+	return true;
+}
+
+void EBYTE_MmapSink::sync() {
+
+	if (_map) {
+		msync(_map, _pos, MS_ASYNC);
+	}
+}
+
+void EBYTE_MmapSink::close() {
+
+	if (_map) {
+		msync(_map, _pos, MS_SYNC);
+		munmap(_map, _size);
+		_map = NULL;
+	}
+
+	if (_fd >= 0) {
+		if (ftruncate(_fd, _pos) != 0) {
+			// the file keeps its zero filled tail, the decoder skips it
+		}
+		::close(_fd);
+		_fd = -1;
+	}
+
+	_size = 0;
+}
+
+#endif
+
+EBYTE_E220_RxLog::EBYTE_E220_RxLog(EBYTE_E220_Receiver *receiver, EBYTE_BlockSink *sink) {
+
+	_receiver = receiver;
+	_sink = sink;
+	_active = 0;
+	_seq = 0;
+	_records = 0;
+	_dropped = 0;
+	_written = 0;
+	_errors = 0;
+	_maxWrite = 0;
+
+	Start(0);
+	Start(1);
+}
+
+bool EBYTE_E220_RxLog::begin(uint8_t type) {
+	return _receiver->onFrame(FrameHandler, this, type);
+}
+
+void EBYTE_E220_RxLog::FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx) {
+	((EBYTE_E220_RxLog *) ctx)->log(type, data, len, rssi);
+}
+
+/*
+method to get a block ready to fill
+*/
+
+void EBYTE_E220_RxLog::Start(uint8_t b) {
+
+	uint8_t *block = _blocks[b];
+
+	memset(block, 0, EBYTE_RXLOG_BLOCK);
+	block[0] = 'E';
+	block[1] = 'L';
+	block[2] = EBYTE_RXLOG_VERSION;
+	block[3] = EBYTE_RXLOG_BLOCK / 256;
+
+	_used[b] = EBYTE_RXLOG_HEADER;
+	_full[b] = false;
+}
+
+/*
+method to append a record, a record never spans blocks, when it doesn't fit the block is
+done and the other one takes over if it has been written out
+*/
+
+bool EBYTE_E220_RxLog::log(uint8_t type, const uint8_t *data, uint8_t len, int16_t rssi) {
+
+	uint16_t need = EBYTE_RXLOG_RECORD + len;
+
+	if (need > EBYTE_RXLOG_BLOCK - EBYTE_RXLOG_HEADER) {
+		_dropped++;
+		return false;
+	}
+
+	if (_full[_active] || _used[_active] + need > EBYTE_RXLOG_BLOCK) {
+
+		_full[_active] = true;
+
+		if (_full[_active ^ 1]) {
+			_dropped++;
+			return false;
+		}
+
+		_active ^= 1;
+	}
+
+	uint8_t *p = _blocks[_active] + _used[_active];
+	unsigned long now = millis();
+
+	if (rssi < -127 || rssi > 127) {
+		rssi = EBYTE_RXLOG_NO_RSSI;
+	}
+
+	p[0] = now & 0xFF;
+	p[1] = (now >> 8) & 0xFF;
+	p[2] = (now >> 16) & 0xFF;
+	p[3] = (now >> 24) & 0xFF;
+	p[4] = (uint8_t) (int8_t) rssi;
+	p[5] = type;
+	p[6] = len;
+	memcpy(p + EBYTE_RXLOG_RECORD, data, len);
+
+	_used[_active] += need;
+	_records++;
+
+	return true;
+}
+
+/*
+method to write a block out and start it again
+*/
+
+void EBYTE_E220_RxLog::Write(uint8_t b) {
+
+	uint8_t *block = _blocks[b];
+	unsigned long t = micros();
+
+	// numbered as they are written, flush() can write a block out of turn
+	block[4] = _seq & 0xFF;
+	block[5] = _seq >> 8;
+	block[6] = _used[b] & 0xFF;
+	block[7] = _used[b] >> 8;
+	_seq++;
+
+	if (_sink->write(block, EBYTE_RXLOG_BLOCK)) {
+		_written++;
+	}
+	else {
+		_errors++;
+	}
+
+	t = micros() - t;
+	if (t > _maxWrite) {
+		_maxWrite = t;
+	}
+
+	Start(b);
+}
+
+void EBYTE_E220_RxLog::service() {
+
+	// the block not being filled is always the older one
+	if (_full[_active ^ 1]) {
+		Write(_active ^ 1);
+	}
+}
+
+void EBYTE_E220_RxLog::flush() {
+
+	service();
+
+	if (_used[_active] > EBYTE_RXLOG_HEADER) {
+		Write(_active);
+	}
+
+	_sink->sync();
+}
+
+uint32_t EBYTE_E220_RxLog::getRecords() {
+	return _records;
+}
+
+uint32_t EBYTE_E220_RxLog::getDropped() {
+	return _dropped;
+}
+
+uint32_t EBYTE_E220_RxLog::getBlocks() {
+	return _written;
+}
+
+uint32_t EBYTE_E220_RxLog::getWriteErrors() {
+	return _errors;
+}
+
+unsigned long EBYTE_E220_RxLog::getMaxWrite() {
+	return _maxWrite;
+}
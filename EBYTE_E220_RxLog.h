@@ -0,0 +1,196 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Binary log of received frames for the EBYTE_E220 library
+
+  Printing every frame to Serial takes longer than the frame at the higher air data rates. The
+  log instead appends each frame to a block in memory as a small binary record, which costs the
+  same few microseconds whatever the frame. There are two blocks, while one fills the other is
+  written out by service() from loop() in one large write (an SD card is much faster with 512 byte
+  writes than with a few bytes at a time). A full block waits for service(), a frame that finds
+  both blocks full is counted in getDropped().
+
+  Where the blocks go is up to an EBYTE_BlockSink. EBYTE_PrintSink writes to any Print (an SD
+  File, a Serial port), and on Linux EBYTE_MmapSink writes to a memory mapped file.
+
+  file format, all values little endian, the file is a series of blocks
+  block header (8 bytes)
+	0	'E' 'L'		magic
+	2	1			version
+	3	uint8		block size / 256
+	4	uint16		block sequence number
+	6	uint16		bytes used in the block, header included, the rest is zeros
+  record (7 bytes + data)
+	0	uint32		millis() when the frame was handled
+	4	int8		RSSI in dBm, -128 if the module isn't adding RSSI bytes
+	5	uint8		frame type
+	6	uint8		length of the data
+	7	data
+
+  extras/RxLogDecode has a program to print a log on the host
+
+  EBYTE_PrintSink Sink(&LogFile);
+  EBYTE_E220_RxLog Log(&Receiver, &Sink);
+
+  Log.begin();						// logs every frame, begin(type) for one type
+  ...
+  void loop() {
+	Receiver.service();
+	Log.service();
+  }
+  ...
+  Log.flush();						// before closing the file
+*/
+
+#ifndef EBYTE_E220_RXLOG_H_LIB
+#define EBYTE_E220_RXLOG_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// block size, one SD sector, a multiple of 256
+#ifndef EBYTE_RXLOG_BLOCK
+#if defined(__AVR__)
+#define EBYTE_RXLOG_BLOCK 256
+#else
+#define EBYTE_RXLOG_BLOCK 512
+#endif
+#endif
+
+#define EBYTE_RXLOG_HEADER 8
+#define EBYTE_RXLOG_RECORD 7
+#define EBYTE_RXLOG_VERSION 1
+
+// RSSI when the frame came without one
+#define EBYTE_RXLOG_NO_RSSI -128
+
+/*
+where full blocks go, write() gets a whole block and returns false if it couldn't be written
+*/
+
+class EBYTE_BlockSink {
+
+public:
+
+	virtual bool write(const uint8_t *block, uint16_t len) = 0;
+	virtual void sync() {}
+
+};
+
+class EBYTE_PrintSink : public EBYTE_BlockSink {
+
+public:
+
+	EBYTE_PrintSink(Print *p);
+
+	bool write(const uint8_t *block, uint16_t len);
+
+private:
+
+	Print *_p;
+
+};
+
+#if defined(__linux__)
+
+/*
+sink for a Linux gateway, the file is mapped into memory and grown as needed, so writing a
+block is a memcpy and the kernel writes it back. close() trims the file to what was written
+*/
+
+class EBYTE_MmapSink : public EBYTE_BlockSink {
+
+public:
+
+	EBYTE_MmapSink();
+	~EBYTE_MmapSink();
+
+	bool open(const char *path, size_t reserve = 1024UL * 1024UL);
+	void close();
+
+	bool write(const uint8_t *block, uint16_t len);
+	void sync();
+
+private:
+
+	bool Grow(size_t size);
+
+	int _fd;
+	uint8_t *_map;
+	size_t _size;
+	size_t _pos;
+
+};
+
+#endif
+
+class EBYTE_E220_RxLog {
+
+public:
+
+	EBYTE_E220_RxLog(EBYTE_E220_Receiver *receiver, EBYTE_BlockSink *sink);
+
+	bool begin(uint8_t type = EBYTE_FRAME_ANY);
+
+	// add a record yourself, begin() does this for every frame
+	bool log(uint8_t type, const uint8_t *data, uint8_t len, int16_t rssi);
+
+	// write a full block if there is one
+	void service();
+
+	// write everything, the block being filled too, and sync the sink
+	void flush();
+
+	uint32_t getRecords();
+	uint32_t getDropped();
+	uint32_t getBlocks();
+	uint32_t getWriteErrors();
+	unsigned long getMaxWrite();		// longest block write (us)
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void Start(uint8_t b);
+	void Write(uint8_t b);
+
+	EBYTE_E220_Receiver *_receiver;
+	EBYTE_BlockSink *_sink;
+
+	uint8_t _blocks[2][EBYTE_RXLOG_BLOCK];
+	uint16_t _used[2];
+	bool _full[2];
+	uint8_t _active;
+	uint16_t _seq;
+
+	uint32_t _records;
+	uint32_t _dropped;
+	uint32_t _written;
+	uint32_t _errors;
+	unsigned long _maxWrite;
+
+};
+
+#endif
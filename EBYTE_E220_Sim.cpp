@@ -0,0 +1,501 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Sim.h>
+
+// factory defaults from the data sheet
+static const uint8_t Defaults[8] = {0x00, 0x00, 0x62, 0x00, 0x12, 0x03, 0x00, 0x00};
+
+// what the read command returns past the 8 registers (PRODINFO and friends)
+static const uint8_t ProductInfo[3] = {0x20, 0x0B, 0x00};
+
+EBYTE_E220_Sim::EBYTE_E220_Sim() {
+
+	memcpy(_regs, Defaults, sizeof(_regs));
+	memcpy(_saved, Defaults, sizeof(_saved));
+
+	_peerCount = 0;
+	_mode = EBYTE_MODE_NORMAL;
+	_rxHead = 0;
+	_rxCount = 0;
+	_txCount = 0;
+	_airLen = 0;
+	_onAir = false;
+	_airWake = false;
+	_airTarget = 0xFFFF;
+	_airChan = 0;
+	_airEnd = 0;
+	_msgStart = true;
+	_target = 0xFFFF;
+	_targetChan = 0;
+	_lastWrite = 0;
+	_busyUntil = 0;
+	_loss = 0;
+	_signal = -60;
+	_noise = -110;
+	_lastRSSI = -128;
+	_sent = 0;
+	_lost = 0;
+	_bytes = 0;
+}
+
+void EBYTE_E220_Sim::link(EBYTE_E220_Sim *peer) {
+	AddPeer(peer);
+	peer->AddPeer(this);
+}
+
+void EBYTE_E220_Sim::AddPeer(EBYTE_E220_Sim *peer) {
+
+	for (uint8_t i = 0; i < _peerCount; i++) {
+		if (_peers[i] == peer) {
+			return;
+		}
+	}
+	if (_peerCount < EBYTE_SIM_PEERS) {
+		_peers[_peerCount++] = peer;
+	}
+}
+
+void EBYTE_E220_Sim::setLoss(uint8_t percent) {
+	_loss = percent;
+}
+
+void EBYTE_E220_Sim::setSignal(int16_t rssi) {
+	_signal = rssi;
+}
+
+void EBYTE_E220_Sim::setNoise(int16_t noise) {
+	_noise = noise;
+}
+
+/*
+pin interface, the library calls this instead of (or as well as) writing M0 and M1
+*/
+
+void EBYTE_E220_Sim::setMode(uint8_t mode) {
+
+	// finish whatever would have happened before the pins changed
+	update();
+
+	if (mode != _mode) {
+		// anything half typed is lost on a mode change
+		_txCount = 0;
+		_msgStart = true;
+	}
+	_mode = mode;
+	_busyUntil = micros() + EBYTE_SIM_MODE_TIME;
+}
+
+bool EBYTE_E220_Sim::getAux() {
+
+	update();
+
+	if ((int32_t) (micros() - _busyUntil) < 0) {
+		return LOW;
+	}
+	if (_onAir || (_txCount && _mode != MODE_PROGRAM)) {
+		return LOW;
+	}
+	return HIGH;
+}
+
+/*
+Stream interface
+*/
+
+int EBYTE_E220_Sim::available() {
+	update();
+	return _rxCount;
+}
+
+int EBYTE_E220_Sim::read() {
+
+	update();
+
+	if (_rxCount == 0) {
+		return -1;
+	}
+
+	uint8_t c = _rx[_rxHead];
+	_rxHead = (_rxHead + 1) % EBYTE_SIM_BUFFER;
+	_rxCount--;
+
+	return c;
+}
+
+int EBYTE_E220_Sim::peek() {
+
+	update();
+
+	if (_rxCount == 0) {
+		return -1;
+	}
+	return _rx[_rxHead];
+}
+
+size_t EBYTE_E220_Sim::write(uint8_t c) {
+
+	uint32_t now = micros();
+
+	update();
+
+	// can't talk to the module while it sleeps
+	if (_mode == MODE_POWERDOWN) {
+		return 1;
+	}
+
+	// a pause on the UART marks the start of a new message (matters for fixed point headers)
+	if (_txCount == 0 && (now - _lastWrite) >= IdleTime()) {
+		_msgStart = true;
+	}
+	_lastWrite = now;
+
+	if (_txCount < EBYTE_SIM_BUFFER) {
+		_tx[_txCount++] = c;
+	}
+
+	if (_mode == MODE_PROGRAM) {
+		HandleProgram();
+	}
+
+	return 1;
+}
+
+void EBYTE_E220_Sim::flush() {
+	update();
+}
+
+/*
+move the simulation along, finish any packet whose air time is up and start the next one
+*/
+
+void EBYTE_E220_Sim::update() {
+
+	// the other modules keep running even if only this one is being polled
+	Step();
+	for (uint8_t i = 0; i < _peerCount; i++) {
+		_peers[i]->Step();
+	}
+}
+
+void EBYTE_E220_Sim::Step() {
+
+	uint32_t now = micros();
+
+	// the simulation is only advanced when someone looks, so work out when things would have
+	// happened and catch up, possibly finishing several packets in one go
+	for (;;) {
+
+		if (_onAir) {
+			if ((int32_t) (now - _airEnd) < 0) {
+				return;
+			}
+			_onAir = false;
+			Deliver(_air, _airLen, _airTarget, _airChan, _airWake);
+		}
+
+		if (_txCount == 0 || (_mode != EBYTE_MODE_NORMAL && _mode != MODE_WAKEUP)) {
+			return;
+		}
+
+		// module sends once a sub packet is full or the UART goes quiet
+		uint32_t start = _lastWrite;
+		if (_txCount < EBYTE_PacketBytes(_regs[3] >> 6)) {
+			start += IdleTime();
+		}
+		if ((int32_t) (now - start) < 0) {
+			return;
+		}
+		// can't start before the previous packet finished
+		if ((int32_t) (_airEnd - start) > 0) {
+			start = _airEnd;
+		}
+
+		if (!HandleRSSI()) {
+			StartPacket(start);
+		}
+	}
+}
+
+uint8_t EBYTE_E220_Sim::getMode() {
+	return _mode;
+}
+
+uint8_t EBYTE_E220_Sim::getRegister(uint8_t reg) {
+	return reg < 8 ? _regs[reg] : 0;
+}
+
+uint32_t EBYTE_E220_Sim::getPacketsSent() {
+	return _sent;
+}
+
+uint32_t EBYTE_E220_Sim::getPacketsLost() {
+	return _lost;
+}
+
+uint32_t EBYTE_E220_Sim::getBytesSent() {
+	return _bytes;
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_Sim::Push(uint8_t c) {
+
+	if (_rxCount < EBYTE_SIM_BUFFER) {
+		_rx[(_rxHead + _rxCount) % EBYTE_SIM_BUFFER] = c;
+		_rxCount++;
+	}
+}
+
+void EBYTE_E220_Sim::Consume(uint16_t count) {
+
+	if (count > _txCount) {
+		count = _txCount;
+	}
+	memmove(_tx, _tx + count, _txCount - count);
+	_txCount -= count;
+}
+
+// time for 3 characters at the configured UART rate
+uint32_t EBYTE_E220_Sim::IdleTime() {
+
+	static const uint32_t Baud[8] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+
+	return 30000000UL / Baud[_regs[2] >> 5];
+}
+
+/*
+program mode, register commands and AT commands
+*/
+
+void EBYTE_E220_Sim::HandleProgram() {
+
+	uint8_t cmd = _tx[0];
+
+	if (cmd == EBYTE_WRITE_PERMANENT || cmd == EBYTE_READ || cmd == EBYTE_WRITE_TEMPORARY) {
+
+		if (_txCount < 3) {
+			return;
+		}
+
+		uint8_t start = _tx[1];
+		uint8_t len = _tx[2];
+
+		if (cmd != EBYTE_READ && _txCount < 3 + len) {
+			return;
+		}
+
+		Push(EBYTE_SUCCESS);
+		Push(start);
+		Push(len);
+
+		for (uint16_t i = start; i < start + len; i++) {
+			if (cmd != EBYTE_READ && i < 8) {
+				_regs[i] = _tx[3 + i - start];
+				if (cmd == EBYTE_WRITE_PERMANENT) {
+					_saved[i] = _regs[i];
+				}
+			}
+			if (i < 6) {
+				Push(_regs[i]);
+			}
+			else if (i < 8) {
+				// the key is write only
+				Push(0);
+			}
+			else {
+				Push(i < 11 ? ProductInfo[i - 8] : 0);
+			}
+		}
+
+		Consume(cmd == EBYTE_READ ? 3 : 3 + len);
+		return;
+	}
+
+	if (cmd == 'A') {
+
+		char line[24];
+		uint16_t len = min(_txCount, (uint16_t) (sizeof(line) - 1));
+
+		memcpy(line, _tx, len);
+		line[len] = '\0';
+
+		char *end = strstr(line, "\r\n");
+		if (end) {
+			*end = '\0';
+			HandleAT(line);
+			Consume((end - line) + 2);
+		}
+		else if (HandleAT(line)) {
+			// AT+RESET and AT+DEFAULT are sent without a line terminator
+			Consume(len);
+		}
+		else if (len == sizeof(line) - 1) {
+			Consume(len);
+		}
+		return;
+	}
+
+	// not a command, the module ignores it
+	Consume(1);
+}
+
+bool EBYTE_E220_Sim::HandleAT(const char *cmd) {
+
+	const char *reply = NULL;
+
+	if (strcmp(cmd, "AT+DEVTYPE=?") == 0) {
+		reply = "DEVTYPE=E220-900T22D\r\n";
+	}
+	else if (strcmp(cmd, "AT+FWCODE=?") == 0) {
+		reply = "FWCODE=7432-0-10\r\n";
+	}
+	else if (strcmp(cmd, "AT+RESET") == 0) {
+		memcpy(_regs, _saved, sizeof(_regs));
+		reply = "=OK\r\n";
+	}
+	else if (strcmp(cmd, "AT+DEFAULT") == 0) {
+		memcpy(_regs, Defaults, sizeof(_regs));
+		memcpy(_saved, Defaults, sizeof(_saved));
+		reply = "=OK\r\n";
+	}
+
+	if (!reply) {
+		return false;
+	}
+
+	while (*reply) {
+		Push(*reply++);
+	}
+	return true;
+}
+
+/*
+the RSSI query works in normal mode, C0 C1 C2 C3 start len
+register 0 is the ambient noise, register 1 the RSSI of the last packet
+*/
+
+bool EBYTE_E220_Sim::HandleRSSI() {
+
+	static const uint8_t Header[4] = {0xC0, 0xC1, 0xC2, 0xC3};
+
+	if (_txCount < 6 || memcmp(_tx, Header, sizeof(Header)) != 0) {
+		return false;
+	}
+
+	uint8_t start = _tx[4];
+	uint8_t len = _tx[5];
+
+	Push(EBYTE_SUCCESS);
+	Push(start);
+	Push(len);
+	for (uint16_t i = start; i < start + len; i++) {
+		int16_t v = (i == 0) ? _noise : _lastRSSI;
+		Push((uint8_t) (256 + v));
+	}
+
+	Consume(6);
+	return true;
+}
+
+void EBYTE_E220_Sim::StartPacket(uint32_t now) {
+
+	// in fixed point mode the first 3 bytes of a message are the target address and channel
+	if (_msgStart) {
+		_msgStart = false;
+		_target = 0xFFFF;
+		_targetChan = _regs[4];
+		if (_regs[5] & 0b01000000) {
+			if (_txCount < 3) {
+				_txCount = 0;
+				return;
+			}
+			_target = (_tx[0] << 8) | _tx[1];
+			_targetChan = _tx[2];
+			Consume(3);
+			if (_txCount == 0) {
+				return;
+			}
+		}
+	}
+
+	_airLen = min(_txCount, (uint16_t) EBYTE_PacketBytes(_regs[3] >> 6));
+	memcpy(_air, _tx, _airLen);
+	Consume(_airLen);
+
+	_airTarget = _target;
+	_airChan = _targetChan;
+	_airWake = (_mode == MODE_WAKEUP);
+
+	uint32_t t = EBYTE_AirTime(_regs[2], _regs[3] >> 6, _airLen);
+
+	// wake up mode adds a preamble as long as the receiver's wake up period
+	if (_airWake) {
+		t += 500000UL * ((_regs[5] & 0b111) + 1);
+	}
+
+	_airEnd = now + t;
+	_onAir = true;
+	_sent++;
+	_bytes += _airLen;
+}
+
+void EBYTE_E220_Sim::Deliver(const uint8_t *data, uint8_t len, uint16_t target, uint8_t chan, bool wake) {
+
+	for (uint8_t i = 0; i < _peerCount; i++) {
+		DeliverTo(_peers[i], data, len, target, chan, wake);
+	}
+}
+
+void EBYTE_E220_Sim::DeliverTo(EBYTE_E220_Sim *p, const uint8_t *data, uint8_t len, uint16_t target, uint8_t chan, bool wake) {
+
+	uint16_t address = (p->_regs[0] << 8) | p->_regs[1];
+
+	// receiver has to be listening on the same channel, rate and key
+	if (p->_mode == MODE_PROGRAM || (p->_mode == MODE_POWERDOWN && !wake)) {
+		return;
+	}
+	if (chan != p->_regs[4] || (_regs[2] & 0b111) != (p->_regs[2] & 0b111)) {
+		return;
+	}
+	if (_regs[6] != p->_regs[6] || _regs[7] != p->_regs[7]) {
+		return;
+	}
+	if (target != 0xFFFF && target != address) {
+		return;
+	}
+
+	if (p->_loss && random(100) < p->_loss) {
+		p->_lost++;
+		return;
+	}
+
+	p->_lastRSSI = p->_signal;
+
+	for (uint8_t i = 0; i < len; i++) {
+		p->Push(data[i]);
+	}
+
+	// RSSI byte appended to each packet if enabled
+	if (p->_regs[5] & 0b10000000) {
+		p->Push((uint8_t) (256 + p->_signal));
+	}
+}
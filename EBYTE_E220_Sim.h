@@ -0,0 +1,157 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Module simulator for the EBYTE_E220 library
+
+  EBYTE_E220_Sim pretends to be an E220 module on the other end of a serial port. It answers the
+  register commands (C0, C1, C2), the AT commands the library uses and the RSSI query, and moves data
+  to a linked simulator after the time the air data rate and sub packet size would take on air.
+  AUX is low while the module is busy just like the real thing. Link two of them to get a radio link
+  with adjustable loss, signal strength and noise--no hardware needed. A simulator can be linked to
+  several others (up to EBYTE_SIM_PEERS) to build a network, it hears only the ones it's linked to
+
+  EBYTE_E220_Sim SimA, SimB;
+  EBYTE_E220 RadioA(&SimA), RadioB(&SimB);
+
+  SimA.link(&SimB);
+  RadioA.setPins(&SimA);
+  RadioB.setPins(&SimB);
+  RadioA.init();
+  RadioB.init();
+
+  The simulator only uses the Arduino Stream class and micros(), so it runs on any board and on a
+  desktop with an Arduino emulation layer such as EpoxyDuino
+*/
+
+#ifndef EBYTE_E220_SIM_H_LIB
+#define EBYTE_E220_SIM_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <Stream.h>
+#include "EBYTE_E220.h"
+
+// bytes buffered in each direction
+#ifndef EBYTE_SIM_BUFFER
+#define EBYTE_SIM_BUFFER 512
+#endif
+
+// most simulators one can be linked to
+#ifndef EBYTE_SIM_PEERS
+#define EBYTE_SIM_PEERS 8
+#endif
+
+// time the simulated module holds AUX low after a mode change (us)
+#define EBYTE_SIM_MODE_TIME 2000
+
+class EBYTE_E220_Sim : public Stream, public EBYTE_E220_Pins {
+
+public:
+
+	EBYTE_E220_Sim();
+
+	// connect two simulators so they can hear each other (call again for more)
+	void link(EBYTE_E220_Sim *peer);
+
+	// link conditions as seen by this module's receiver
+	void setLoss(uint8_t percent);
+	void setSignal(int16_t rssi);
+	void setNoise(int16_t noise);
+
+	// EBYTE_E220_Pins
+	void setMode(uint8_t mode);
+	bool getAux();
+
+	// Stream
+	int available();
+	int read();
+	int peek();
+	size_t write(uint8_t c);
+	using Print::write;
+	void flush();
+
+	// advance the simulation, called from the Stream methods but safe to call any time
+	void update();
+
+	uint8_t getMode();
+	uint8_t getRegister(uint8_t reg);
+	uint32_t getPacketsSent();
+	uint32_t getPacketsLost();
+	uint32_t getBytesSent();
+
+private:
+
+	void Step();
+	void Push(uint8_t c);
+	void Consume(uint16_t count);
+	void HandleProgram();
+	bool HandleAT(const char *cmd);
+	bool HandleRSSI();
+	void StartPacket(uint32_t now);
+	void Deliver(const uint8_t *data, uint8_t len, uint16_t target, uint8_t chan, bool wake);
+	void DeliverTo(EBYTE_E220_Sim *p, const uint8_t *data, uint8_t len, uint16_t target, uint8_t chan, bool wake);
+	void AddPeer(EBYTE_E220_Sim *peer);
+	uint32_t IdleTime();
+
+	EBYTE_E220_Sim *_peers[EBYTE_SIM_PEERS];
+	uint8_t _peerCount;
+
+	uint8_t _regs[8];
+	uint8_t _saved[8];
+	uint8_t _mode;
+
+	uint8_t _rx[EBYTE_SIM_BUFFER];
+	uint16_t _rxHead;
+	uint16_t _rxCount;
+
+	uint8_t _tx[EBYTE_SIM_BUFFER];
+	uint16_t _txCount;
+
+	uint8_t _air[200];
+	uint8_t _airLen;
+	bool _onAir;
+	bool _airWake;
+	uint16_t _airTarget;
+	uint8_t _airChan;
+	uint32_t _airEnd;
+
+	bool _msgStart;
+	uint16_t _target;
+	uint8_t _targetChan;
+
+	uint32_t _lastWrite;
+	uint32_t _busyUntil;
+
+	uint8_t _loss;
+	int16_t _signal;
+	int16_t _noise;
+	int16_t _lastRSSI;
+
+	uint32_t _sent;
+	uint32_t _lost;
+	uint32_t _bytes;
+
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_Stats.h>
+
+#ifdef EBYTE_E220_STATS
+
+void EBYTE_Stats::reset() {
+	memset(this, 0, sizeof(EBYTE_Stats));
+}
+
+void EBYTE_Stats::record(EBYTE_OpStat *op, uint32_t duration) {
+
+	op->Count++;
+	op->Total += duration;
+	if (duration > op->Worst) {
+		op->Worst = duration;
+	}
+}
+
+/*
+add an event to the trace, the oldest event is overwritten when full
+*/
+
+void EBYTE_Stats::trace(uint8_t event, uint32_t arg) {
+
+	uint8_t i = (TraceHead + TraceCount) % EBYTE_TRACE_SIZE;
+
+	Trace[i].Time = micros();
+	Trace[i].Event = event;
+	Trace[i].Arg = arg;
+
+	if (TraceCount < EBYTE_TRACE_SIZE) {
+		TraceCount++;
+	}
+	else {
+		TraceHead = (TraceHead + 1) % EBYTE_TRACE_SIZE;
+	}
+}
+
+void EBYTE_Stats::PrintOp(Print *p, const char *name, EBYTE_OpStat *op) {
+
+	p->print(name);
+	p->print(F(","));
+	p->print(op->Count);
+	p->print(F(","));
+	p->print(op->Total);
+	p->print(F(","));
+	p->print(op->Count ? op->Total / op->Count : 0);
+	p->print(F(","));
+	p->println(op->Worst);
+}
+
+/*
+print the counters as csv so builds can be compared
+*/
+
+void EBYTE_Stats::print(Print *p) {
+
+	p->println(F("op,count,total_us,avg_us,worst_us"));
+	PrintOp(p, "setMode", &SetMode);
+	PrintOp(p, "taskWait", &TaskWait);
+	PrintOp(p, "regRead", &RegRead);
+	PrintOp(p, "regWrite", &RegWrite);
+	PrintOp(p, "rssi", &RSSI);
+	PrintOp(p, "atCommand", &ATCommand);
+	p->print(F("taskTimeouts,"));
+	p->println(TaskTimeouts);
+	p->print(F("bytesDiscarded,"));
+	p->println(BytesDiscarded);
+}
+
+/*
+print and empty the trace, oldest event first
+*/
+
+void EBYTE_Stats::dumpTrace(Print *p) {
+
+	p->println(F("time_us,event,arg"));
+	while (TraceCount) {
+		p->print(Trace[TraceHead].Time);
+		p->print(F(","));
+		p->print(Trace[TraceHead].Event);
+		p->print(F(","));
+		p->println(Trace[TraceHead].Arg);
+		TraceHead = (TraceHead + 1) % EBYTE_TRACE_SIZE;
+		TraceCount--;
+	}
+}
+
+#endif
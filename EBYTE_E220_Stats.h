@@ -0,0 +1,123 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Operation counters and trace for the EBYTE_E220 library
+
+  Uncomment EBYTE_E220_STATS below and each EBYTE_E220 object keeps counts and total / worst case
+  durations (in microseconds) for the operations that take time: mode changes, AUX waits, register
+  reads and writes, RSSI queries and AT commands. The last EBYTE_TRACE_SIZE events are kept with a timestamp so you can see what happened just before a problem.
+
+  Transceiver.getStats()->print(&Serial);
+  Transceiver.getStats()->dumpTrace(&Serial);
+
+  With EBYTE_E220_STATS not defined none of this is compiled and the object is the same size as before.
+  The switch changes the layout of class EBYTE_E220, so the library and the sketch must see the same
+  setting. This file is the only place to set it, defining it anywhere else is an error.
+*/
+
+#ifndef EBYTE_E220_STATS_H_LIB
+#define EBYTE_E220_STATS_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#ifdef EBYTE_E220_STATS
+#error "turn on EBYTE_E220_STATS in EBYTE_E220_Stats.h, not in the sketch or the build flags"
+#endif
+
+// #define EBYTE_E220_STATS
+
+// number of trace events kept
+#ifndef EBYTE_TRACE_SIZE
+#define EBYTE_TRACE_SIZE 32
+#endif
+
+// trace events (arg meaning in brackets)
+#define EBYTE_EVT_SETMODE 1			// mode change done (mode)
+#define EBYTE_EVT_TASK_DONE 2			// AUX went high (us waited)
+#define EBYTE_EVT_TASK_TIMEOUT 3		// AUX wait timed out (us waited)
+#define EBYTE_EVT_CLEAR 4				// ClearBuffer() (bytes discarded)
+#define EBYTE_EVT_REG_READ 5			// register read (first byte returned)
+#define EBYTE_EVT_REG_WRITE 6			// register write (first byte returned)
+#define EBYTE_EVT_RSSI 7				// RSSI query (first byte returned)
+#define EBYTE_EVT_AT 8					// AT command (EBYTE_AT_xxx status)
+
+#ifdef EBYTE_E220_STATS
+
+struct EBYTE_OpStat {
+	uint32_t Count;
+	uint32_t Total;		// us
+	uint32_t Worst;		// us
+};
+
+struct EBYTE_TraceEvent {
+	uint32_t Time;		// micros() at the end of the event
+	uint32_t Arg;
+	uint8_t Event;
+};
+
+class EBYTE_Stats {
+
+public:
+
+	void reset();
+	void record(EBYTE_OpStat *op, uint32_t duration);
+	void trace(uint8_t event, uint32_t arg);
+	void print(Print *p);
+	void dumpTrace(Print *p);
+
+	EBYTE_OpStat SetMode;
+	EBYTE_OpStat TaskWait;
+	EBYTE_OpStat RegRead;
+	EBYTE_OpStat RegWrite;
+	EBYTE_OpStat RSSI;
+	EBYTE_OpStat ATCommand;
+	uint32_t TaskTimeouts;
+	uint32_t BytesDiscarded;
+
+private:
+
+	void PrintOp(Print *p, const char *name, EBYTE_OpStat *op);
+
+	EBYTE_TraceEvent Trace[EBYTE_TRACE_SIZE];
+	uint8_t TraceHead;
+	uint8_t TraceCount;
+
+};
+
+// helpers used inside the library, they vanish when EBYTE_E220_STATS is not defined
+#define EBYTE_STAT_START(t) uint32_t t = micros()
+#define EBYTE_STAT_END(op, t) Stats.record(&Stats.op, micros() - (t))
+#define EBYTE_STAT_ADD(field, n) Stats.field += (n)
+#define EBYTE_TRACE(event, arg) Stats.trace((event), (uint32_t) (arg))
+
+#else
+
+#define EBYTE_STAT_START(t) ((void) 0)
+#define EBYTE_STAT_END(op, t) ((void) 0)
+#define EBYTE_STAT_ADD(field, n) ((void) 0)
+#define EBYTE_TRACE(event, arg) ((void) 0)
+
+#endif
+
+#endif
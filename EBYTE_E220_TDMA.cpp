@@ -0,0 +1,348 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_TDMA.h>
+
+// first byte of every poll frame
+#define TDMA_POLL 1
+#define TDMA_ANSWER 2
+
+EBYTE_E220_TDMAGateway::EBYTE_E220_TDMAGateway(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_handler = NULL;
+	_ctx = NULL;
+	_nodeCount = 0;
+	_current = 0;
+	_seq = 0;
+	_waiting = false;
+	_answered = false;
+	_pollAt = 0;
+	_slot = 0;
+	_cycles = 0;
+	_cycleStart = 0;
+	_cycleTime = 0;
+
+	memset(_nodes, 0, sizeof(_nodes));
+}
+
+bool EBYTE_E220_TDMAGateway::addNode(uint16_t address) {
+
+	if (_nodeCount >= EBYTE_TDMA_NODES) {
+		return false;
+	}
+
+	EBYTE_TDMANodeStats *n = &_nodes[_nodeCount++];
+
+	memset(n, 0, sizeof(EBYTE_TDMANodeStats));
+	n->Address = address;
+	n->Budget = EBYTE_TDMA_MIN_BUDGET;
+
+	return true;
+}
+
+void EBYTE_E220_TDMAGateway::onData(EBYTE_TDMAHandler handler, void *ctx) {
+	_handler = handler;
+	_ctx = ctx;
+}
+
+bool EBYTE_E220_TDMAGateway::begin() {
+
+	_cycleStart = millis();
+	return _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_POLL);
+}
+
+/*
+a slot ends when the answer is in or its time is up, then the next node is polled as soon as the module is free
+*/
+
+void EBYTE_E220_TDMAGateway::service() {
+
+	unsigned long now = millis();
+
+	if (_nodeCount == 0) {
+		return;
+	}
+
+	if (_waiting) {
+		if (!_answered && (now - _pollAt) < _slot) {
+			return;
+		}
+		if (!_answered) {
+			_nodes[_current].Misses++;
+		}
+		_waiting = false;
+		NextSlot();
+	}
+
+	if (!_radio->getAux()) {
+		return;
+	}
+
+	EBYTE_TDMANodeStats *n = &_nodes[_current];
+	uint8_t poll[EBYTE_TDMA_POLL];
+
+	_slot = (_radio->getAirTime(EBYTE_FRAME_OVERHEAD + EBYTE_TDMA_POLL) / 1000) +
+		(_radio->getAirTime(EBYTE_FRAME_OVERHEAD + EBYTE_TDMA_HEADER + n->Budget) / 1000) + EBYTE_TDMA_GUARD;
+
+	if (n->LastPoll) {
+		uint16_t interval = min(now - n->LastPoll, 65535UL);
+		n->Interval = n->Interval ? (uint16_t) ((3UL * n->Interval + interval) / 4) : interval;
+	}
+	n->LastPoll = now;
+
+	_seq++;
+	poll[0] = TDMA_POLL;
+	poll[1] = _seq;
+	poll[2] = n->Budget;
+	poll[3] = min((_slot + 9) / 10, 255UL);
+	poll[4] = _radio->getAddressH();
+	poll[5] = _radio->getAddressL();
+	poll[6] = _radio->getChannel();
+
+	_radio->sendFrame(n->Address, _radio->getChannel(), EBYTE_FRAME_POLL, poll, sizeof(poll));
+
+	n->Polls++;
+	_waiting = true;
+	_answered = false;
+	_pollAt = millis();
+}
+
+uint8_t EBYTE_E220_TDMAGateway::getNodeCount() {
+	return _nodeCount;
+}
+
+EBYTE_TDMANodeStats *EBYTE_E220_TDMAGateway::getNode(uint8_t i) {
+	return (i < _nodeCount) ? &_nodes[i] : NULL;
+}
+
+uint32_t EBYTE_E220_TDMAGateway::getCycles() {
+	return _cycles;
+}
+
+unsigned long EBYTE_E220_TDMAGateway::getCycleTime() {
+	return _cycleTime;
+}
+
+/*
+method to print the per node statistics, one line per node
+*/
+
+void EBYTE_E220_TDMAGateway::printStats(Print *p) {
+
+	p->print(F("cycles "));
+	p->print(_cycles);
+	p->print(F(", last cycle ms "));
+	p->println(_cycleTime);
+	p->println(F("  addr  polls  answers  misses   bytes budget  avg_B  lat_ms  interval_ms"));
+
+	for (uint8_t i = 0; i < _nodeCount; i++) {
+
+		EBYTE_TDMANodeStats *n = &_nodes[i];
+		char line[96];
+
+		snprintf(line, sizeof(line), "  %04X %6lu %8lu %7lu %7lu %6u %6u %7u %12u",
+			n->Address, (unsigned long) n->Polls, (unsigned long) n->Answers, (unsigned long) n->Misses,
+			(unsigned long) n->Bytes, n->Budget, n->AvgBytes / 16, n->Latency, n->Interval);
+		p->println(line);
+	}
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_TDMAGateway::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_TDMAGateway*) ctx)->GotAnswer(data, len);
+}
+
+/*
+hand the records on, then size the next budget, a full sub packet if the node has more
+waiting, otherwise half again its average so a growing node isn't cut short
+*/
+
+void EBYTE_E220_TDMAGateway::GotAnswer(uint8_t *data, uint8_t len) {
+
+	if (len < EBYTE_TDMA_HEADER || data[0] != TDMA_ANSWER || !_waiting || _answered || data[1] != _seq) {
+		return;
+	}
+
+	EBYTE_TDMANodeStats *n = &_nodes[_current];
+	uint16_t latency = min(millis() - _pollAt, 65535UL);
+	uint8_t bytes = len - EBYTE_TDMA_HEADER;
+
+	_answered = true;
+	n->Answers++;
+	n->Latency = n->Latency ? (uint16_t) ((3UL * n->Latency + latency) / 4) : latency;
+	n->More = data[2];
+	n->AvgBytes = (uint16_t) (n->AvgBytes + (((int16_t) bytes * 16) - (int16_t) n->AvgBytes) / 4);
+
+	for (uint8_t pos = EBYTE_TDMA_HEADER; pos < len; ) {
+		uint8_t size = data[pos++];
+		if (size == 0 || pos + size > len) {
+			break;
+		}
+		if (_handler) {
+			_handler(n->Address, data + pos, size, _ctx);
+		}
+		n->Bytes += size;
+		pos += size;
+	}
+
+	if (n->More) {
+		n->Budget = MaxBudget();
+	}
+	else {
+		n->Budget = constrain((uint16_t) (((n->AvgBytes * 3) / 32) + EBYTE_TDMA_MIN_BUDGET), EBYTE_TDMA_MIN_BUDGET, MaxBudget());
+	}
+}
+
+void EBYTE_E220_TDMAGateway::NextSlot() {
+
+	if (++_current >= _nodeCount) {
+		unsigned long now = millis();
+		_current = 0;
+		_cycles++;
+		_cycleTime = now - _cycleStart;
+		_cycleStart = now;
+	}
+}
+
+// an answer has to fit one sub packet
+
+uint8_t EBYTE_E220_TDMAGateway::MaxBudget() {
+	return min((uint8_t) (_radio->getPacketBytes() - EBYTE_FRAME_OVERHEAD - EBYTE_TDMA_HEADER), (uint8_t) (EBYTE_FRAME_MAX - EBYTE_TDMA_HEADER));
+}
+
+/*
+the node
+*/
+
+EBYTE_E220_TDMANode::EBYTE_E220_TDMANode(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_used = 0;
+	_polled = false;
+	_seq = 0;
+	_budget = 0;
+	_slot = 0;
+	_pollAt = 0;
+	_gateway = 0;
+	_channel = 0;
+	_polls = 0;
+	_late = 0;
+}
+
+bool EBYTE_E220_TDMANode::begin() {
+	return _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_POLL);
+}
+
+// records are kept as [len][data] so the gateway gets them back one by one
+
+bool EBYTE_E220_TDMANode::write(const uint8_t *data, uint8_t len) {
+
+	uint8_t largest = min((uint8_t) (_radio->getPacketBytes() - EBYTE_FRAME_OVERHEAD - EBYTE_TDMA_HEADER), (uint8_t) (EBYTE_FRAME_MAX - EBYTE_TDMA_HEADER));
+
+	if (len == 0 || len + 1 > largest || (uint16_t) _used + len + 1 > EBYTE_TDMA_BUFFER) {
+		return false;
+	}
+
+	_buffer[_used++] = len;
+	memcpy(_buffer + _used, data, len);
+	_used += len;
+
+	return true;
+}
+
+/*
+answer with as many whole records as the budget holds, but only if the answer can be on air
+before the slot closes, a late answer would run into the next node's slot
+*/
+
+void EBYTE_E220_TDMANode::service() {
+
+	if (!_polled || !_radio->getAux()) {
+		return;
+	}
+
+	uint8_t answer[EBYTE_FRAME_MAX];
+	uint8_t take = 0;
+
+	_polled = false;
+
+	while (take < _used && take + 1 + _buffer[take] <= _budget) {
+		take += 1 + _buffer[take];
+	}
+
+	// the slot started when the gateway wrote the poll, about one poll air time before we got it
+	unsigned long air = (_radio->getAirTime(EBYTE_FRAME_OVERHEAD + EBYTE_TDMA_POLL) + _radio->getAirTime(EBYTE_FRAME_OVERHEAD + EBYTE_TDMA_HEADER + take)) / 1000;
+
+	if ((millis() - _pollAt) + air > _slot) {
+		_late++;
+		return;
+	}
+
+	answer[0] = TDMA_ANSWER;
+	answer[1] = _seq;
+	answer[2] = (take < _used) ? 1 : 0;
+	memcpy(answer + EBYTE_TDMA_HEADER, _buffer, take);
+
+	_radio->sendFrame(_gateway, _channel, EBYTE_FRAME_POLL, answer, EBYTE_TDMA_HEADER + take);
+
+	memmove(_buffer, _buffer + take, _used - take);
+	_used -= take;
+}
+
+uint8_t EBYTE_E220_TDMANode::pending() {
+	return _used;
+}
+
+uint32_t EBYTE_E220_TDMANode::getPolls() {
+	return _polls;
+}
+
+uint32_t EBYTE_E220_TDMANode::getLate() {
+	return _late;
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_TDMANode::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t, void *ctx) {
+	((EBYTE_E220_TDMANode*) ctx)->GotPoll(data, len);
+}
+
+void EBYTE_E220_TDMANode::GotPoll(uint8_t *data, uint8_t len) {
+
+	if (len < EBYTE_TDMA_POLL || data[0] != TDMA_POLL) {
+		return;
+	}
+
+	_polled = true;
+	_seq = data[1];
+	_budget = data[2];
+	_slot = data[3] * 10UL;
+	_gateway = ((uint16_t) data[4] << 8) | data[5];
+	_channel = data[6];
+	_pollAt = millis();
+	_polls++;
+}
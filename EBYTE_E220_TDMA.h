@@ -0,0 +1,189 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Polled time slots for one gateway and many nodes with the EBYTE_E220 library
+
+  With many nodes on one channel, nodes that talk whenever they like collide. Here only the gateway
+  decides who talks. It polls each node in turn with a fixed point message (TRM_FIXEDPOINT, so only
+  that node's module passes it on), and the node answers straight away with whatever it has queued,
+  up to the byte budget in the poll. A node never sends unless polled, and it doesn't answer a poll
+  it can't finish answering inside the slot.
+
+  A slot lasts the poll's air time, the air time of the budget, and a turnaround guard. The gateway
+  keeps an average of what each node sends and a flag for data left over, and sizes the next budget
+  from them. A quiet node gets a short slot, a busy one gets up to a full sub packet. A slot ends as
+  soon as the answer is in, so the cycle is only as long as the traffic needs.
+
+  gateway                                      node
+  EBYTE_E220_TDMAGateway Gateway(&T, &R);      EBYTE_E220_TDMANode Node(&T, &R);
+  Gateway.addNode(0x0101);                     Node.begin();
+  Gateway.addNode(0x0102);                     ...
+  Gateway.onData(GotData, NULL);               Node.write((uint8_t*) &Reading, sizeof(Reading));
+  Gateway.begin();                             loop() { R.service(); Node.service(); }
+  loop() { R.service(); Gateway.service(); }
+
+  All modules need TRM_FIXEDPOINT, their own address and the same channel and air data rate.
+  Gateway.printStats() shows per node polls, misses, budget and latency.
+*/
+
+#ifndef EBYTE_E220_TDMA_H_LIB
+#define EBYTE_E220_TDMA_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// nodes a gateway polls
+#ifndef EBYTE_TDMA_NODES
+#define EBYTE_TDMA_NODES 16
+#endif
+
+// bytes a node can queue (each record costs one extra byte)
+#ifndef EBYTE_TDMA_BUFFER
+#define EBYTE_TDMA_BUFFER 128
+#endif
+
+// smallest budget, a node with nothing to say still gets room to say it has something
+#define EBYTE_TDMA_MIN_BUDGET 8
+
+// turnaround time in a slot (ms), the node's UART and module latency both ways
+#define EBYTE_TDMA_GUARD 60
+
+// poll header, op + seq + budget + slot time (10 ms units) + gateway address and channel
+#define EBYTE_TDMA_POLL 7
+
+// answer header, op + seq + data left over flag
+#define EBYTE_TDMA_HEADER 3
+
+// called for each record a node wrote
+typedef void (*EBYTE_TDMAHandler)(uint16_t address, uint8_t *data, uint8_t len, void *ctx);
+
+struct EBYTE_TDMANodeStats {
+	uint16_t Address;
+	uint32_t Polls;
+	uint32_t Answers;
+	uint32_t Misses;			// no answer inside the slot
+	uint32_t Bytes;				// record bytes received
+	uint8_t Budget;				// bytes offered next poll
+	uint16_t AvgBytes;			// average answer size, x16
+	bool More;					// node said it had data left over
+	uint16_t Latency;			// average poll to answer (ms)
+	uint16_t Interval;			// average time between polls (ms), the most a record waits
+	unsigned long LastPoll;
+};
+
+class EBYTE_E220_TDMAGateway {
+
+public:
+
+	EBYTE_E220_TDMAGateway(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	bool addNode(uint16_t address);
+	void onData(EBYTE_TDMAHandler handler, void *ctx);
+
+	// after the radio settings are final
+	bool begin();
+
+	// call often, one poll per slot
+	void service();
+
+	uint8_t getNodeCount();
+	EBYTE_TDMANodeStats *getNode(uint8_t i);
+	uint32_t getCycles();
+	unsigned long getCycleTime();		// ms, last full cycle
+	void printStats(Print *p);
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotAnswer(uint8_t *data, uint8_t len);
+	void NextSlot();
+	uint8_t MaxBudget();
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	EBYTE_TDMAHandler _handler;
+	void *_ctx;
+
+	EBYTE_TDMANodeStats _nodes[EBYTE_TDMA_NODES];
+	uint8_t _nodeCount;
+
+	uint8_t _current;
+	uint8_t _seq;
+	bool _waiting;
+	bool _answered;
+	unsigned long _pollAt;
+	unsigned long _slot;
+
+	uint32_t _cycles;
+	unsigned long _cycleStart;
+	unsigned long _cycleTime;
+
+};
+
+class EBYTE_E220_TDMANode {
+
+public:
+
+	EBYTE_E220_TDMANode(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver);
+
+	bool begin();
+
+	// queue a record for the next poll, false if it doesn't fit
+	bool write(const uint8_t *data, uint8_t len);
+
+	// call often, answers a poll while its slot is still open
+	void service();
+
+	uint8_t pending();			// bytes queued
+	uint32_t getPolls();
+	uint32_t getLate();			// polls not answered because the slot had passed
+
+private:
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotPoll(uint8_t *data, uint8_t len);
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	uint8_t _buffer[EBYTE_TDMA_BUFFER];
+	uint8_t _used;
+
+	bool _polled;
+	uint8_t _seq;
+	uint8_t _budget;
+	unsigned long _slot;
+	unsigned long _pollAt;
+	uint16_t _gateway;
+	uint8_t _channel;
+
+	uint32_t _polls;
+	uint32_t _late;
+
+};
+
+#endif
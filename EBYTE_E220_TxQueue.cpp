@@ -0,0 +1,490 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_TxQueue.h>
+#include <EBYTE_E220_Log.h>
+
+EBYTE_E220_TxQueue::EBYTE_E220_TxQueue(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver) {
+
+	_radio = radio;
+	_receiver = receiver;
+	_count = 0;
+	_order = 0;
+	_nextId = 0;
+	_threshold = EBYTE_TXQ_THRESHOLD;
+	_sending = false;
+	_sawLow = false;
+	_attempt = 0;
+	_backoffStart = 0;
+	_backoff = 0;
+	_sendStart = 0;
+	_expected = 0;
+	_noise = -999;
+	_checks = 0;
+	_busyChecks = 0;
+	_sent = 0;
+	_backoffs = 0;
+	_forced = 0;
+	_deferred = 0;
+	_deferredTime = 0;
+	_airTime = 0;
+	_timeouts = 0;
+	_expired = 0;
+	_evicted = 0;
+	_pieces = 0;
+	_maxDepth = 0;
+
+	memset(_slots, 0, sizeof(_slots));
+}
+
+bool EBYTE_E220_TxQueue::send(uint8_t type, const uint8_t *data, uint8_t len, uint8_t priority, unsigned long deadline) {
+	return Push(false, 0, 0, type, data, len, priority, deadline);
+}
+
+bool EBYTE_E220_TxQueue::send(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len, uint8_t priority, unsigned long deadline) {
+	return Push(true, address, channel, type, data, len, priority, deadline);
+}
+
+void EBYTE_E220_TxQueue::setThreshold(int16_t dbm) {
+	_threshold = dbm;
+}
+
+/*
+one message (or piece) at a time, drop anything past its deadline, wait out any backoff,
+check the channel, send the most important message, then time AUX until the module is done with it
+*/
+
+void EBYTE_E220_TxQueue::service() {
+
+	unsigned long now = millis();
+
+	if (_sending) {
+
+		unsigned long elapsed = now - _sendStart;
+
+		// AUX may take a moment to drop after the write, if we never see it low the air time will do
+		if (!_radio->getAux()) {
+			_sawLow = true;
+			if (elapsed > _expected + EBYTE_TXQ_TIMEOUT) {
+				EBYTE_LOGE(EBYTE_ERR_TX_TIMEOUT, elapsed);
+				_timeouts++;
+				Finish(elapsed);
+			}
+			return;
+		}
+		if (_sawLow || elapsed >= _expected) {
+			Finish(elapsed);
+		}
+		return;
+	}
+
+	Expire(now);
+
+	if (_count == 0 || (now - _backoffStart) < _backoff) {
+		return;
+	}
+
+	if (!ChannelClear()) {
+		if (++_attempt < EBYTE_TXQ_ATTEMPTS) {
+			unsigned long window = min((unsigned long) EBYTE_TXQ_BACKOFF_MIN << _attempt, (unsigned long) EBYTE_TXQ_BACKOFF_MAX);
+			_backoff = random(1, window + 1);
+			_backoffStart = millis();
+			_backoffs++;
+			EBYTE_LOGD(EBYTE_LOG_TX_BACKOFF, _backoff);
+			return;
+		}
+		// still busy, hand it to the module and let its LBT hold it back
+		_forced++;
+	}
+
+	SendNext(&_slots[Pick()]);
+
+	_sendStart = millis();
+	_sawLow = false;
+	_sending = true;
+	_attempt = 0;
+	_backoff = 0;
+}
+
+uint8_t EBYTE_E220_TxQueue::pending() {
+	return _count;
+}
+
+bool EBYTE_E220_TxQueue::busy() {
+	return _count || _sending;
+}
+
+uint8_t EBYTE_E220_TxQueue::getOccupancy() {
+	return _checks ? (uint8_t) ((100UL * _busyChecks) / _checks) : 0;
+}
+
+int16_t EBYTE_E220_TxQueue::getNoise() {
+	return _noise;
+}
+
+uint32_t EBYTE_E220_TxQueue::getSent() {
+	return _sent;
+}
+
+uint32_t EBYTE_E220_TxQueue::getBackoffs() {
+	return _backoffs;
+}
+
+uint32_t EBYTE_E220_TxQueue::getForced() {
+	return _forced;
+}
+
+uint32_t EBYTE_E220_TxQueue::getDeferred() {
+	return _deferred;
+}
+
+uint32_t EBYTE_E220_TxQueue::getDeferredTime() {
+	return _deferredTime;
+}
+
+uint32_t EBYTE_E220_TxQueue::getAirTime() {
+	return _airTime;
+}
+
+uint32_t EBYTE_E220_TxQueue::getTimeouts() {
+	return _timeouts;
+}
+
+uint32_t EBYTE_E220_TxQueue::getExpired() {
+	return _expired;
+}
+
+uint32_t EBYTE_E220_TxQueue::getEvicted() {
+	return _evicted;
+}
+
+uint32_t EBYTE_E220_TxQueue::getPieces() {
+	return _pieces;
+}
+
+uint8_t EBYTE_E220_TxQueue::getMaxDepth() {
+	return _maxDepth;
+}
+
+/*
+method to print the statistics
+*/
+
+void EBYTE_E220_TxQueue::printStats(Print *p) {
+
+	p->print(F("Sent: "));			p->println(_sent);
+	p->print(F("Air time ms: "));		p->println(_airTime);
+	p->print(F("Occupancy %: "));		p->println(getOccupancy());
+	p->print(F("Noise dBm: "));		p->println(_noise);
+	p->print(F("Backoffs: "));		p->println(_backoffs);
+	p->print(F("Forced: "));			p->println(_forced);
+	p->print(F("Deferred: "));		p->println(_deferred);
+	p->print(F("Deferred ms: "));		p->println(_deferredTime);
+	p->print(F("Timeouts: "));		p->println(_timeouts);
+	p->print(F("Expired: "));			p->println(_expired);
+	p->print(F("Evicted: "));			p->println(_evicted);
+	p->print(F("Pieces: "));			p->println(_pieces);
+	p->print(F("Max depth: "));		p->println(_maxDepth);
+}
+
+/*
+private methods
+*/
+
+/*
+a full queue makes room by dropping its least important message, if that's less important than the new one
+*/
+
+bool EBYTE_E220_TxQueue::Push(bool fixed, uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len, uint8_t priority, unsigned long deadline) {
+
+	Slot *slot = NULL;
+
+	if (len > EBYTE_TXQ_PAYLOAD) {
+		return false;
+	}
+
+	if (_count >= EBYTE_TXQ_SLOTS) {
+		for (uint8_t i = 0; i < EBYTE_TXQ_SLOTS; i++) {
+			if (!slot || Before(slot, &_slots[i])) {
+				slot = &_slots[i];
+			}
+		}
+		if (slot->Priority >= priority) {
+			return false;
+		}
+		slot->Used = false;
+		_count--;
+		_evicted++;
+	}
+	else {
+		for (uint8_t i = 0; i < EBYTE_TXQ_SLOTS; i++) {
+			if (!_slots[i].Used) {
+				slot = &_slots[i];
+				break;
+			}
+		}
+	}
+
+	slot->Used = true;
+	slot->Type = type;
+	slot->Fixed = fixed;
+	slot->Address = address;
+	slot->Channel = channel;
+	slot->Priority = priority;
+	slot->HasDeadline = (deadline != 0);
+	slot->Deadline = millis() + deadline;
+	slot->Order = _order++;
+	slot->Id = 0;
+	slot->Piece = 0;
+	slot->Offset = 0;
+	slot->Len = len;
+	memcpy(slot->Data, data, len);
+
+	_count++;
+	_maxDepth = max(_maxDepth, _count);
+
+	return true;
+}
+
+// true if a should go out before b, priority, then earliest deadline, then oldest
+
+bool EBYTE_E220_TxQueue::Before(Slot *a, Slot *b) {
+
+	if (a->Priority != b->Priority) {
+		return a->Priority > b->Priority;
+	}
+	if (a->HasDeadline != b->HasDeadline) {
+		return a->HasDeadline;
+	}
+	if (a->HasDeadline && a->Deadline != b->Deadline) {
+		return (long) (a->Deadline - b->Deadline) < 0;
+	}
+	return (int32_t) (a->Order - b->Order) < 0;
+}
+
+int8_t EBYTE_E220_TxQueue::Pick() {
+
+	int8_t best = -1;
+
+	for (uint8_t i = 0; i < EBYTE_TXQ_SLOTS; i++) {
+		if (_slots[i].Used && (best < 0 || Before(&_slots[i], &_slots[best]))) {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+void EBYTE_E220_TxQueue::Expire(unsigned long now) {
+
+	for (uint8_t i = 0; i < EBYTE_TXQ_SLOTS; i++) {
+		Slot *slot = &_slots[i];
+		if (slot->Used && slot->HasDeadline && (long) (now - slot->Deadline) >= 0) {
+			// a message cut off part way is dropped by the reassembler when its next one starts
+			slot->Used = false;
+			_count--;
+			_expired++;
+		}
+	}
+}
+
+/*
+a message that fits one sub packet goes as it is, a bigger one goes one sub packet sized piece per call
+*/
+
+void EBYTE_E220_TxQueue::SendNext(Slot *slot) {
+
+	uint8_t room = min((uint8_t) (_radio->getPacketBytes() - EBYTE_FRAME_OVERHEAD - (slot->Fixed ? 3 : 0)), (uint8_t) EBYTE_FRAME_MAX);
+	uint8_t buf[EBYTE_FRAME_MAX];
+	uint8_t *data = slot->Data;
+	uint8_t type = slot->Type;
+	uint8_t len = slot->Len;
+
+	if (slot->Offset > 0 || slot->Len > room) {
+
+		uint8_t chunk = min((uint8_t) (room - EBYTE_FRAG_HEADER), (uint8_t) (slot->Len - slot->Offset));
+
+		if (slot->Offset == 0) {
+			slot->Id = _nextId++;
+		}
+
+		buf[0] = slot->Id;
+		buf[1] = slot->Piece | ((slot->Offset + chunk >= slot->Len) ? 0x80 : 0);
+		buf[2] = slot->Type;
+		memcpy(buf + EBYTE_FRAG_HEADER, slot->Data + slot->Offset, chunk);
+
+		data = buf;
+		type = EBYTE_FRAME_FRAG;
+		len = EBYTE_FRAG_HEADER + chunk;
+
+		slot->Offset += chunk;
+		slot->Piece++;
+		_pieces++;
+	}
+	else {
+		slot->Offset = slot->Len;
+	}
+
+	if (slot->Fixed) {
+		_radio->sendFrame(slot->Address, slot->Channel, type, data, len);
+	}
+	else {
+		_radio->sendFrame(type, data, len);
+	}
+
+	_expected = _radio->getAirTime(EBYTE_FRAME_OVERHEAD + len) / 1000;
+
+	if (slot->Offset >= slot->Len) {
+		slot->Used = false;
+		_count--;
+	}
+}
+
+// AUX first (free), the noise read only if the module looks idle
+
+bool EBYTE_E220_TxQueue::ChannelClear() {
+
+	bool clear = _radio->getAux();
+
+	// the RSSI reply can't be told apart from a frame arriving at the same time
+	if (clear && (_receiver == NULL || _receiver->idle())) {
+		_noise = _radio->readRSSIAmbientNoise();
+		clear = (_noise == -999) || (_noise < _threshold);
+	}
+
+	_checks++;
+	if (!clear) {
+		_busyChecks++;
+	}
+
+	return clear;
+}
+
+void EBYTE_E220_TxQueue::Finish(unsigned long elapsed) {
+
+	_sending = false;
+	_sent++;
+	_airTime += _expected;
+
+	if (elapsed > _expected + EBYTE_TXQ_SLACK) {
+		_deferred++;
+		_deferredTime += elapsed - _expected;
+	}
+}
+
+/*
+the reassembler, pieces of one message arrive in order (one sender, one link) but pieces of
+different messages can be mixed when a more important message cut in
+*/
+
+EBYTE_E220_Reassembler::EBYTE_E220_Reassembler(EBYTE_E220_Receiver *receiver) {
+
+	_receiver = receiver;
+	_messages = 0;
+	_dropped = 0;
+
+	memset(_slots, 0, sizeof(_slots));
+}
+
+bool EBYTE_E220_Reassembler::begin() {
+	return _receiver->onFrame(FrameHandler, this, EBYTE_FRAME_FRAG);
+}
+
+uint32_t EBYTE_E220_Reassembler::getMessages() {
+	return _messages;
+}
+
+uint32_t EBYTE_E220_Reassembler::getDropped() {
+	return _dropped;
+}
+
+void EBYTE_E220_Reassembler::FrameHandler(uint8_t, uint8_t *data, uint8_t len, int16_t rssi, void *ctx) {
+	((EBYTE_E220_Reassembler*) ctx)->GotPiece(data, len, rssi);
+}
+
+void EBYTE_E220_Reassembler::GotPiece(uint8_t *data, uint8_t len, int16_t rssi) {
+
+	if (len < EBYTE_FRAG_HEADER) {
+		return;
+	}
+
+	unsigned long now = millis();
+	uint8_t id = data[0];
+	uint8_t piece = data[1] & 0x7F;
+	bool last = data[1] & 0x80;
+	uint8_t n = len - EBYTE_FRAG_HEADER;
+	Slot *slot = NULL;
+
+	for (uint8_t i = 0; i < EBYTE_REASM_SLOTS; i++) {
+		if (_slots[i].Used && _slots[i].Id == id) {
+			slot = &_slots[i];
+			break;
+		}
+	}
+
+	if (piece == 0) {
+
+		// a free slot, else one that timed out, else the oldest
+		if (!slot) {
+			for (uint8_t i = 0; i < EBYTE_REASM_SLOTS; i++) {
+				if (!_slots[i].Used) {
+					slot = &_slots[i];
+					break;
+				}
+				if (!slot || (now - _slots[i].Started) > (now - slot->Started)) {
+					slot = &_slots[i];
+				}
+			}
+		}
+		if (slot->Used) {
+			_dropped++;
+		}
+
+		slot->Used = true;
+		slot->Id = id;
+		slot->Type = data[2];
+		slot->Next = 0;
+		slot->Len = 0;
+		slot->Started = now;
+	}
+	else if (!slot || slot->Next != piece || (now - slot->Started) > EBYTE_REASM_TIMEOUT) {
+		// missed a piece, the rest is no use
+		if (slot) {
+			slot->Used = false;
+			_dropped++;
+		}
+		return;
+	}
+
+	if ((uint16_t) slot->Len + n > EBYTE_TXQ_PAYLOAD) {
+		slot->Used = false;
+		_dropped++;
+		return;
+	}
+
+	memcpy(slot->Data + slot->Len, data + EBYTE_FRAG_HEADER, n);
+	slot->Len += n;
+	slot->Next++;
+
+	if (last) {
+		slot->Used = false;
+		_messages++;
+		_receiver->deliver(slot->Type, slot->Data, slot->Len, rssi);
+	}
+}
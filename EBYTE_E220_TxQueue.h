@@ -0,0 +1,243 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Listen before talk priority transmit queue for the EBYTE_E220 library
+
+  With setLBTEnable(true) the module holds a send back while the channel is busy, but the host
+  only sees AUX stay low for longer than it should. This queue sits in front of the module, and
+  before each send it
+  1. checks AUX (low means the module is still sending, or receiving, or holding something back)
+  2. reads the ambient noise (if RSSI ambient noise is on) and compares it with the threshold.
+     the reply would get mixed up with a frame coming in, so on a node that also receives pass
+     the receiver and the noise is only read while it's idle, otherwise AUX alone decides
+  and if either says the channel is busy it waits a random time from a window that doubles
+  on every busy check (randomized exponential backoff) instead of piling more data into the module.
+  After EBYTE_TXQ_ATTEMPTS busy checks it sends anyway and leaves it to the module's own LBT.
+
+  Each send is timed from the write until AUX comes back, anything over the expected air time
+  is counted as deferred, so the statistics show how busy the channel really is
+
+  Messages have a priority (higher goes first) and optionally a deadline (ms from when they're
+  queued), equal priorities go earliest deadline first, then oldest first. A message still queued
+  at its deadline is dropped, and when the queue is full a new message pushes out the lowest
+  priority one if that is lower than its own. A message bigger than one sub packet goes out one
+  sub packet at a time (EBYTE_FRAME_FRAG) and the next piece is picked again after each one, so a
+  high priority message waits at most one sub packet of air time. The receiving end puts the
+  pieces back together with EBYTE_E220_Reassembler and the handlers get the original frame.
+
+  EBYTE_E220_TxQueue Queue(&Transceiver, &Receiver);	// or just &Transceiver on a node that only sends
+
+  Transceiver.setLBTEnable(true);
+  Transceiver.setRSSIAmbientNoise(true);
+  Transceiver.saveParameters(EBYTE_WRITE_TEMPORARY);
+  ...
+  Queue.send(EBYTE_FRAME_DATA, (uint8_t*) &LapData, sizeof(LapData), 3, 500);	// priority 3, 500 ms
+  Queue.send(EBYTE_FRAME_DATA, (uint8_t*) &LogData, sizeof(LogData));			// priority 0, no deadline
+  ...
+  void loop() {
+    Queue.service();
+  }
+
+  receiving end
+  EBYTE_E220_Reassembler Reassembler(&Receiver);
+  Reassembler.begin();
+*/
+
+#ifndef EBYTE_E220_TXQUEUE_H_LIB
+#define EBYTE_E220_TXQUEUE_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// messages held
+#ifndef EBYTE_TXQ_SLOTS
+#define EBYTE_TXQ_SLOTS 8
+#endif
+
+// largest message (frame payload), messages bigger than a sub packet are sent in pieces
+#ifndef EBYTE_TXQ_PAYLOAD
+#define EBYTE_TXQ_PAYLOAD 128
+#endif
+
+// piece header, message id + index (0x80 set on the last piece) + the message's frame type
+#define EBYTE_FRAG_HEADER 3
+
+// messages being put back together at once on the receiving end
+#ifndef EBYTE_REASM_SLOTS
+#define EBYTE_REASM_SLOTS 2
+#endif
+
+// a message still missing pieces after this long (ms) is dropped
+#define EBYTE_REASM_TIMEOUT 5000
+
+// noise (dBm) at or above which the channel is taken as busy
+#define EBYTE_TXQ_THRESHOLD -90
+
+// backoff window (ms) on the first busy check, doubles each time up to the max
+#define EBYTE_TXQ_BACKOFF_MIN 20
+#define EBYTE_TXQ_BACKOFF_MAX 2000
+
+// busy checks before sending anyway
+#define EBYTE_TXQ_ATTEMPTS 6
+
+// AUX low this much longer than the air time (ms) counts as a deferred send
+#define EBYTE_TXQ_SLACK 20
+
+// AUX low this much longer than the air time (ms) is a failed send
+#define EBYTE_TXQ_TIMEOUT 5000
+
+class EBYTE_E220_TxQueue {
+
+public:
+
+	EBYTE_E220_TxQueue(EBYTE_E220 *radio, EBYTE_E220_Receiver *receiver = NULL);
+
+	// queue a frame, false if it's too big or the queue is full of messages at least as important
+	// deadline is ms from now (0 for none), the second is for fixed point transmission
+	bool send(uint8_t type, const uint8_t *data, uint8_t len, uint8_t priority = 0, unsigned long deadline = 0);
+	bool send(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len, uint8_t priority = 0, unsigned long deadline = 0);
+
+	void setThreshold(int16_t dbm);
+
+	// call often, sends at most one message (or one piece of one) per call
+	void service();
+
+	uint8_t pending();
+	bool busy();				// something queued or still going out
+
+	// statistics
+	uint8_t getOccupancy();		// percent of channel checks that found it busy
+	int16_t getNoise();			// last ambient noise reading, -999 if off
+	uint32_t getSent();
+	uint32_t getBackoffs();
+	uint32_t getForced();		// sent after EBYTE_TXQ_ATTEMPTS busy checks
+	uint32_t getDeferred();		// sends that took longer than the air time
+	uint32_t getDeferredTime();	// ms AUX stayed low over the air time
+	uint32_t getAirTime();		// ms of expected air time sent
+	uint32_t getTimeouts();
+	uint32_t getExpired();		// dropped at their deadline
+	uint32_t getEvicted();		// pushed out by a more important message
+	uint32_t getPieces();		// sub packet pieces of big messages sent
+	uint8_t getMaxDepth();
+	void printStats(Print *p);
+
+private:
+
+	struct Slot {
+		bool Used;
+		uint8_t Type;
+		bool Fixed;
+		uint16_t Address;
+		uint8_t Channel;
+		uint8_t Priority;
+		bool HasDeadline;
+		unsigned long Deadline;
+		uint32_t Order;
+		uint8_t Id;				// message id once the first piece is out
+		uint8_t Piece;			// next piece
+		uint8_t Offset;			// bytes already sent
+		uint8_t Len;
+		uint8_t Data[EBYTE_TXQ_PAYLOAD];
+	};
+
+	bool Push(bool fixed, uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len, uint8_t priority, unsigned long deadline);
+	bool Before(Slot *a, Slot *b);
+	int8_t Pick();
+	void Expire(unsigned long now);
+	bool ChannelClear();
+	void SendNext(Slot *slot);
+	void Finish(unsigned long elapsed);
+
+	EBYTE_E220 *_radio;
+	EBYTE_E220_Receiver *_receiver;
+
+	Slot _slots[EBYTE_TXQ_SLOTS];
+	uint8_t _count;
+	uint32_t _order;
+	uint8_t _nextId;
+
+	int16_t _threshold;
+	bool _sending;
+	bool _sawLow;
+	uint8_t _attempt;
+	unsigned long _backoffStart;
+	unsigned long _backoff;
+	unsigned long _sendStart;
+	unsigned long _expected;
+
+	int16_t _noise;
+	uint32_t _checks;
+	uint32_t _busyChecks;
+	uint32_t _sent;
+	uint32_t _backoffs;
+	uint32_t _forced;
+	uint32_t _deferred;
+	uint32_t _deferredTime;
+	uint32_t _airTime;
+	uint32_t _timeouts;
+	uint32_t _expired;
+	uint32_t _evicted;
+	uint32_t _pieces;
+	uint8_t _maxDepth;
+
+};
+
+class EBYTE_E220_Reassembler {
+
+public:
+
+	EBYTE_E220_Reassembler(EBYTE_E220_Receiver *receiver);
+
+	bool begin();
+
+	uint32_t getMessages();
+	uint32_t getDropped();		// messages missing a piece
+
+private:
+
+	struct Slot {
+		bool Used;
+		uint8_t Id;
+		uint8_t Type;
+		uint8_t Next;			// piece expected next
+		uint8_t Len;
+		unsigned long Started;
+		uint8_t Data[EBYTE_TXQ_PAYLOAD];
+	};
+
+	static void FrameHandler(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx);
+	void GotPiece(uint8_t *data, uint8_t len, int16_t rssi);
+
+	EBYTE_E220_Receiver *_receiver;
+
+	Slot _slots[EBYTE_REASM_SLOTS];
+
+	uint32_t _messages;
+	uint32_t _dropped;
+
+};
+
+#endif
@@ -0,0 +1,246 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <EBYTE_E220_WOR.h>
+
+// marks a saved state as ours
+#define WOR_MAGIC 0x57
+
+EBYTE_E220_WOR::EBYTE_E220_WOR(EBYTE_E220 *radio) {
+
+	_radio = radio;
+	_listening = false;
+	_sending = false;
+	_sawLow = false;
+	_sentAt = 0;
+	_expected = 0;
+	_sent = 0;
+	_timeouts = 0;
+}
+
+/*
+methods for the energy and latency model, these don't need a module so they can be used for planning
+*/
+
+unsigned long EBYTE_E220_WOR::period(uint8_t wor) {
+	return 500UL * ((wor & 0b111) + 1);
+}
+
+// the preamble always lasts a whole period, then the packet itself
+
+unsigned long EBYTE_E220_WOR::latency(uint8_t wor, uint8_t adr, uint8_t bytes) {
+	return period(wor) + (EBYTE_AirTime(adr, SUB_200BYTES, EBYTE_FRAME_OVERHEAD + bytes) / 1000);
+}
+
+/*
+the node sleeps, wakes every period to listen for about one preamble's worth of symbols, and for each
+message listens to what's left of the preamble (half a period on average) and the packet
+a sender on battery sleeps between messages and transmits the whole preamble and the packet
+*/
+
+float EBYTE_E220_WOR::averageCurrent(uint8_t wor, uint8_t adr, float perHour, uint8_t bytes, bool sender) {
+
+	float t = period(wor);
+	float air = EBYTE_AirTime(adr, SUB_200BYTES, EBYTE_FRAME_OVERHEAD + bytes) / 1000.0;
+	float charge;		// mA ms per message
+	float idle;			// mA
+
+	if (sender) {
+		idle = EBYTE_WOR_SLEEP_MA;
+		charge = EBYTE_WOR_TRANSMIT_MA * (t + air);
+	}
+	else {
+		float listen = (EBYTE_AIR_OVERHEAD * 8 * 1000.0 / EBYTE_AirDataRate(adr)) + (EBYTE_WOR_WAKE / 1000.0);
+		idle = EBYTE_WOR_SLEEP_MA + ((EBYTE_WOR_RECEIVE_MA - EBYTE_WOR_SLEEP_MA) * listen / t);
+		charge = EBYTE_WOR_RECEIVE_MA * ((t / 2) + air);
+	}
+
+	return idle + (perHour * charge / 3600000.0);
+}
+
+uint8_t EBYTE_E220_WOR::choosePeriod(unsigned long maxLatency, uint8_t adr, float perHour, uint8_t bytes, bool senderOnBattery) {
+
+	uint8_t best = EBYTE_WOR_NONE;
+	float lowest = 0;
+
+	for (uint8_t wor = WOR_WAKEUP500; wor <= OPT_WAKEUP4000; wor++) {
+
+		if (latency(wor, adr, bytes) > maxLatency) {
+			break;
+		}
+
+		float current = averageCurrent(wor, adr, perHour, bytes);
+
+		if (senderOnBattery) {
+			current += averageCurrent(wor, adr, perHour, bytes, true);
+		}
+		if (best == EBYTE_WOR_NONE || current < lowest) {
+			best = wor;
+			lowest = current;
+		}
+	}
+
+	return best;
+}
+
+// REG3 holds the WOR period, the register write leaves the module in normal mode
+
+bool EBYTE_E220_WOR::setPeriod(uint8_t wor, uint8_t val) {
+
+	_radio->setWORTIming(wor);
+
+	bool ok = _radio->saveRegisters(5, 1, val);
+
+	if (_listening && !_sending) {
+		_radio->setMode(MODE_POWERDOWN);
+	}
+
+	return ok;
+}
+
+bool EBYTE_E220_WOR::sendFrame(uint8_t type, const uint8_t *data, uint8_t len) {
+
+	if (_sending || len > EBYTE_FRAME_MAX) {
+		return false;
+	}
+
+	StartSend();
+	_radio->sendFrame(type, data, len);
+	_expected = period(_radio->getWORTIming()) + (_radio->getAirTime(EBYTE_FRAME_OVERHEAD + len) / 1000);
+
+	return true;
+}
+
+bool EBYTE_E220_WOR::sendFrame(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len) {
+
+	if (_sending || len > EBYTE_FRAME_MAX) {
+		return false;
+	}
+
+	StartSend();
+	_radio->sendFrame(address, channel, type, data, len);
+	_expected = period(_radio->getWORTIming()) + (_radio->getAirTime(EBYTE_FRAME_OVERHEAD + len) / 1000);
+
+	return true;
+}
+
+/*
+wait for AUX to come back after the preamble and packet, then go back to normal (or to WOR receive)
+*/
+
+void EBYTE_E220_WOR::service() {
+
+	if (!_sending) {
+		return;
+	}
+
+	unsigned long elapsed = millis() - _sentAt;
+
+	if (!_radio->getAux()) {
+		_sawLow = true;
+		if (elapsed > _expected + EBYTE_WOR_TIMEOUT) {
+			_timeouts++;
+			Done();
+		}
+		return;
+	}
+
+	if (_sawLow || elapsed >= _expected) {
+		Done();
+	}
+}
+
+bool EBYTE_E220_WOR::busy() {
+	return _sending;
+}
+
+void EBYTE_E220_WOR::listen() {
+
+	_listening = true;
+
+	if (!_sending) {
+		_radio->setMode(MODE_POWERDOWN);
+	}
+}
+
+void EBYTE_E220_WOR::stop() {
+
+	_listening = false;
+
+	if (!_sending) {
+		_radio->setMode(EBYTE_MODE_NORMAL);
+	}
+}
+
+bool EBYTE_E220_WOR::woke() {
+	return _listening && !_sending && !_radio->getAux();
+}
+
+void EBYTE_E220_WOR::saveState(EBYTE_WORState *state) {
+
+	_radio->getRegisters(state->Registers);
+	state->Mode = _listening ? MODE_POWERDOWN : EBYTE_MODE_NORMAL;
+	state->Magic = WOR_MAGIC;
+	state->Crc = EBYTE_CRC8((uint8_t*) state, sizeof(EBYTE_WORState) - 1);
+}
+
+// false if the state is not one we saved (first power up, memory lost), call init() then
+
+bool EBYTE_E220_WOR::resume(const EBYTE_WORState *state) {
+
+	if (state->Magic != WOR_MAGIC || state->Crc != EBYTE_CRC8((const uint8_t*) state, sizeof(EBYTE_WORState) - 1)) {
+		return false;
+	}
+
+	_listening = (state->Mode == MODE_POWERDOWN);
+	_sending = false;
+
+	return _radio->init(state->Registers, state->Mode);
+}
+
+uint32_t EBYTE_E220_WOR::getSent() {
+	return _sent;
+}
+
+uint32_t EBYTE_E220_WOR::getTimeouts() {
+	return _timeouts;
+}
+
+/*
+private methods
+*/
+
+void EBYTE_E220_WOR::StartSend() {
+
+	if (_radio->getMode() != MODE_WAKEUP) {
+		_radio->setMode(MODE_WAKEUP);
+	}
+
+	_sending = true;
+	_sawLow = false;
+	_sentAt = millis();
+}
+
+void EBYTE_E220_WOR::Done() {
+
+	_sending = false;
+	_sent++;
+
+	_radio->setMode(_listening ? MODE_POWERDOWN : EBYTE_MODE_NORMAL);
+}
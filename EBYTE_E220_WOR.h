@@ -0,0 +1,135 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2019 Kris Kasrpzak
+  Permission is hereby granted, free of charge, to any person obtaining a copy of
+  this software and associated documentation files (the "Software"), to deal in
+  the Software without restriction, including without limitation the rights to
+  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+  the Software, and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+  FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+  COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+  Wake on radio for the EBYTE_E220 library
+
+  A battery node leaves its module in WOR receive mode (MODE_POWERDOWN), where it sleeps and wakes
+  every WOR period just long enough to listen for a preamble. A sender in wake up mode (MODE_WAKEUP)
+  puts a preamble as long as the period in front of each packet so the node is sure to hear it.
+  The period is a trade, a long one costs less while idle but every message costs more (the sender
+  transmits, and the node listens to, the whole preamble) and takes longer to arrive.
+
+  The model below estimates average current and latency for each period and choosePeriod() picks
+  the lowest current that still meets a latency target
+
+  uint8_t wor = EBYTE_E220_WOR::choosePeriod(2500, ADR_2400, 12, sizeof(MyData));	// 2.5 s, 12 an hour
+  Wor.setPeriod(wor);		// both ends
+
+  sender                                  node
+  Wor.sendFrame(type, data, len);         Wor.listen();
+  loop() { Wor.service(); }               loop() { Receiver.service(); ... sleep the MCU until AUX falls }
+
+  The MCU can keep an EBYTE_WORState (11 bytes) in memory that survives its own deep sleep and
+  call resume() on waking instead of init(), no AT commands, register reads or mode round trips
+
+  The current figures are typical data sheet values for the 22 dBm module, measure yours and change
+  them if you need real numbers
+*/
+
+#ifndef EBYTE_E220_WOR_H_LIB
+#define EBYTE_E220_WOR_H_LIB
+
+#if ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "EBYTE_E220.h"
+
+// module current (mA)
+#ifndef EBYTE_WOR_SLEEP_MA
+#define EBYTE_WOR_SLEEP_MA 0.005
+#endif
+#ifndef EBYTE_WOR_RECEIVE_MA
+#define EBYTE_WOR_RECEIVE_MA 17.0
+#endif
+#ifndef EBYTE_WOR_TRANSMIT_MA
+#define EBYTE_WOR_TRANSMIT_MA 110.0
+#endif
+
+// time (us) to wake and settle each WOR period before listening for a preamble
+#define EBYTE_WOR_WAKE 1000
+
+// extra time (ms) allowed for a wake up send to finish before giving up on AUX
+#define EBYTE_WOR_TIMEOUT 1000
+
+// no period meets the latency target
+#define EBYTE_WOR_NONE 0xFF
+
+struct EBYTE_WORState {
+	uint8_t Registers[8];		// from EBYTE_E220::getRegisters()
+	uint8_t Mode;
+	uint8_t Magic;
+	uint8_t Crc;
+};
+
+class EBYTE_E220_WOR {
+
+public:
+
+	EBYTE_E220_WOR(EBYTE_E220 *radio);
+
+	// model, wor is WOR_WAKEUP500 to OPT_WAKEUP4000
+	static unsigned long period(uint8_t wor);		// ms
+	static unsigned long latency(uint8_t wor, uint8_t adr, uint8_t bytes);		// ms, send to delivery
+	static float averageCurrent(uint8_t wor, uint8_t adr, float perHour, uint8_t bytes, bool sender = false);	// mA
+	static uint8_t choosePeriod(unsigned long maxLatency, uint8_t adr, float perHour, uint8_t bytes, bool senderOnBattery = false);
+
+	// set the WOR period, both ends need the same
+	bool setPeriod(uint8_t wor, uint8_t val = EBYTE_WRITE_TEMPORARY);
+
+	// sender, switches to wake up mode, service() switches back once it's out
+	bool sendFrame(uint8_t type, const uint8_t *data, uint8_t len);
+	bool sendFrame(uint16_t address, uint8_t channel, uint8_t type, const uint8_t *data, uint8_t len);
+	void service();
+	bool busy();
+
+	// node
+	void listen();
+	void stop();
+	bool woke();			// module has data for us (AUX low)
+
+	// state that lets the MCU skip init() after it slept
+	void saveState(EBYTE_WORState *state);
+	bool resume(const EBYTE_WORState *state);
+
+	uint32_t getSent();
+	uint32_t getTimeouts();
+
+private:
+
+	void StartSend();
+	void Done();
+
+	EBYTE_E220 *_radio;
+
+	bool _listening;
+	bool _sending;
+	bool _sawLow;
+	unsigned long _sentAt;
+	unsigned long _expected;
+
+	uint32_t _sent;
+	uint32_t _timeouts;
+
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*
+
+  This example benchmarks the library against two simulated modules
+  no hardware is needed, it runs on any board (a Teensy is nice as it's fast)
+  and on a desktop, either with an Arduino emulation layer such as EpoxyDuino or with the
+  Makefile in extras/Benchmark, which builds it against the library's own host Arduino.h
+
+  Results are printed as csv, one line per operation
+  op,runs,wall_us,cpu_us
+
+  wall_us is the average time the call took (including the library's delays and AUX waits)
+  cpu_us is the average processor time, on a desktop this shows how much of the wall time was
+  spent actually working vs waiting. on an MCU the library busy waits so the two are the same
+
+  the data path ends with a throughput line under its own header
+  op,runs,bytes,Bps
+
+  compare the output between library versions to spot changes in wait behavior
+
+*/
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+#include "EBYTE_E220_Sim.h"
+
+#if defined(EPOXY_DUINO) || defined(EBYTE_HOST)
+#include <time.h>
+#define DESKTOP
+#endif
+
+#define RUNS 5
+
+// the README's example application, 48 bytes sent every second
+struct DATA {
+  unsigned long Count;
+  float Values[11];
+};
+
+EBYTE_E220_Sim SimA, SimB;
+
+EBYTE_E220 RadioA(&SimA);
+EBYTE_E220 RadioB(&SimB);
+EBYTE_E220_Receiver ReceiverB(&SimB);
+
+DATA MyData;
+unsigned long Received;
+
+unsigned long WallStart, CPUStart;
+
+unsigned long CPUTime() {
+#if defined(DESKTOP)
+  return (unsigned long) (clock() * (1000000.0 / CLOCKS_PER_SEC));
+#else
+  return micros();
+#endif
+}
+
+void Start() {
+  WallStart = micros();
+  CPUStart = CPUTime();
+}
+
+void Stop(const char *op, unsigned long runs) {
+  unsigned long wall = micros() - WallStart;
+  unsigned long cpu = CPUTime() - CPUStart;
+  Serial.print(op);
+  Serial.print(",");
+  Serial.print(runs);
+  Serial.print(",");
+  Serial.print(wall / runs);
+  Serial.print(",");
+  Serial.println(cpu / runs);
+}
+
+void OnData(uint8_t, uint8_t *data, uint8_t len, int16_t, void *) {
+  memcpy(&MyData, data, len);
+  Received += len;
+}
+
+void setup() {
+
+  Serial.begin(115200);
+
+  SimA.link(&SimB);
+  RadioA.setPins(&SimA);
+  RadioB.setPins(&SimB);
+
+  Serial.println("op,runs,wall_us,cpu_us");
+
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    RadioA.init();
+  }
+  Stop("init", RUNS);
+
+  RadioB.init();
+
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    RadioA.saveParameters(EBYTE_WRITE_TEMPORARY);
+  }
+  Stop("saveParameters", RUNS);
+
+  // channel only
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    RadioA.saveRegisters(4, 1, EBYTE_WRITE_TEMPORARY);
+  }
+  Stop("saveRegisters", RUNS);
+
+  RadioA.setRSSIAmbientNoise(true);
+  RadioA.setRSSISignalStrength(true);
+  RadioA.saveParameters(EBYTE_WRITE_TEMPORARY);
+
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    RadioA.readRSSIAmbientNoise();
+  }
+  Stop("readRSSIAmbientNoise", RUNS);
+
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    RadioA.readRSSISignalStrength();
+  }
+  Stop("readRSSISignalStrength", RUNS);
+
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    RadioA.setMode(MODE_POWERDOWN);
+    RadioA.setMode(EBYTE_MODE_NORMAL);
+  }
+  Stop("setMode", RUNS * 2);
+
+  // data path, time from sendFrame() until the receiver has handed the whole struct over
+  RadioA.setRSSISignalStrength(false);
+  RadioA.saveParameters(EBYTE_WRITE_TEMPORARY);
+
+  RadioB.attachReceiver(&ReceiverB);
+  ReceiverB.onFrame(OnData, NULL, EBYTE_FRAME_DATA);
+
+  Received = 0;
+  Start();
+  for (int i = 0; i < RUNS; i++) {
+    unsigned long got = Received;
+    unsigned long t = millis();
+    MyData.Count = i;
+    RadioA.sendFrame(EBYTE_FRAME_DATA, (uint8_t*) &MyData, sizeof(MyData));
+    while ((Received == got) && ((millis() - t) < 1000)) {
+      ReceiverB.service();
+    }
+  }
+  unsigned long wall = micros() - WallStart;
+  Stop("sendReceive", RUNS);
+
+  Serial.println("op,runs,bytes,Bps");
+  Serial.print("throughput,");
+  Serial.print(RUNS);
+  Serial.print(",");
+  Serial.print(Received);
+  Serial.print(",");
+  Serial.println(wall ? (Received * 1000000.0) / wall : 0);
+
+}
+
+void loop() {
+
+#if defined(DESKTOP)
+  exit(0);
+#endif
+
+}
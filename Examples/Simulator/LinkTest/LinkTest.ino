@@ -0,0 +1,75 @@
+/*
+
+  This example measures round trip time, loss and goodput for a set of air data rates
+  and sub packet sizes using two simulated modules, no hardware is needed
+
+  on real hardware split the sketch over two boards, one calls beginInitiator() and services
+  the initiator, the other calls beginResponder() and services the responder, each with its
+  EBYTE_E220 on the serial port its module is on (both ends must start on the same settings)
+
+  the results are printed as a table, one line per combination
+  rate sub len sent recv loss% min_ms p50_ms p90_ms max_ms B/s
+
+  B/s is payload echoed per second with one ping in flight, it includes the module's
+  wait for its buffer to fill or go idle so it shows where small sub packets pay off
+
+*/
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Sim.h"
+#include "EBYTE_E220_Receiver.h"
+#include "EBYTE_E220_LinkTest.h"
+
+#define PINGS 10
+#define LOSS 10
+
+const uint8_t Rates[] = {ADR_2400, ADR_9600, ADR_38400, ADR_62500};
+const uint8_t Sizes[] = {SUB_32BYTES, SUB_64BYTES, SUB_200BYTES};
+
+EBYTE_E220_Sim SimA, SimB;
+
+EBYTE_E220 RadioA(&SimA);
+EBYTE_E220 RadioB(&SimB);
+
+EBYTE_E220_Receiver ReceiverA(&SimA);
+EBYTE_E220_Receiver ReceiverB(&SimB);
+
+EBYTE_E220_LinkTest Initiator(&RadioA, &ReceiverA);
+EBYTE_E220_LinkTest Responder(&RadioB, &ReceiverB);
+
+void setup() {
+
+  Serial.begin(115200);
+
+  SimA.link(&SimB);
+  SimB.setLoss(LOSS);
+  RadioA.setPins(&SimA);
+  RadioB.setPins(&SimB);
+
+  RadioA.init();
+  RadioB.init();
+
+  RadioA.attachReceiver(&ReceiverA);
+  RadioB.attachReceiver(&ReceiverB);
+
+  Responder.beginResponder();
+  Initiator.beginInitiator(Rates, sizeof(Rates), Sizes, sizeof(Sizes), PINGS);
+
+  unsigned long start = millis();
+
+  while (!Initiator.done()) {
+    ReceiverA.service();
+    Initiator.service();
+    ReceiverB.service();
+    Responder.service();
+  }
+
+  Initiator.printResults(&Serial);
+
+  Serial.print("sweep took ");
+  Serial.print((millis() - start) / 1000);
+  Serial.println(" s");
+}
+
+void loop() {
+}
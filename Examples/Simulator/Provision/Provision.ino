@@ -0,0 +1,98 @@
+/*
+
+  This example programs a manifest of units in batches, one unit per module, with four
+  simulated modules standing in for a programming jig, no hardware is needed
+
+  on a real jig replace the simulators with the serial ports the modules are on and give each
+  EBYTE_E220 its M0, M1 and AUX pins, then swap the modules between batches. the manifest could
+  just as well come from Serial or an SD card, one line at a time
+
+  the report has one line per unit
+  unit address channel key rate power result ms
+
+*/
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Sim.h"
+#include "EBYTE_E220_Manager.h"
+#include "EBYTE_E220_Provision.h"
+
+#define MODULES 4
+
+// address, channel, key, air data rate (bps), transmit power (TRP_xxx code)
+const char *Manifest[] = {
+  "# pit wall gateways",
+  "0x0101, 10, 0xBEEF, 9600, 0",
+  "0x0102, 20, 0xBEEF, 9600, 0",
+  "# cars",
+  "0x0201, 10, 0x1234, 2400, 1",
+  "0x0202, 10, 0x1234, 2400, 1",
+  "0x0203, 20, 0x1234, 2400, 1",
+  "0x0204, 20, 0x1234, 2400, 1",
+  "0x0205, 20, 0x1234, 2400, 1",
+};
+
+EBYTE_E220_Sim Sim[MODULES];
+EBYTE_E220 Radio0(&Sim[0]);
+EBYTE_E220 Radio1(&Sim[1]);
+EBYTE_E220 Radio2(&Sim[2]);
+EBYTE_E220 Radio3(&Sim[3]);
+EBYTE_E220 *Radio[MODULES] = {&Radio0, &Radio1, &Radio2, &Radio3};
+
+EBYTE_E220_Manager Manager;
+EBYTE_E220_Provision Provision(&Manager);
+
+EBYTE_Unit Units[MODULES];
+
+void setup() {
+
+  Serial.begin(115200);
+
+  for (uint8_t i = 0; i < MODULES; i++) {
+    Radio[i]->setPins(&Sim[i]);
+    Manager.add(Radio[i]);
+  }
+
+  uint8_t line = 0;
+  uint8_t batch = 0;
+  uint16_t total = 0, passed = 0;
+  unsigned long start = millis();
+
+  while (line < sizeof(Manifest) / sizeof(Manifest[0])) {
+
+    // fill the jig
+    uint8_t n = 0;
+    while (n < MODULES && line < sizeof(Manifest) / sizeof(Manifest[0])) {
+      if (Provision.parse(Manifest[line], &Units[n], line + 1)) {
+        n++;
+      }
+      line++;
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    Provision.begin(Units, n);
+    while (!Provision.done()) {
+      Provision.service();
+    }
+
+    Serial.print("batch ");
+    Serial.println(batch++);
+    Provision.printReport(&Serial);
+
+    total += n;
+    passed += Provision.getPassed();
+  }
+
+  Serial.print(passed);
+  Serial.print(" of ");
+  Serial.print(total);
+  Serial.print(" units passed in ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+}
+
+void loop() {
+}
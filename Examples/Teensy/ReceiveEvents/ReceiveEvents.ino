@@ -0,0 +1,99 @@
+/*
+
+  This example shows how to receive data with the event driven receiver
+  using a Teensy 3.2
+
+  The receiver drains the serial port in bulk and calls GotData() for every
+  complete struct, nothing blocks in loop() and data that arrives while the
+  library changes settings is kept
+
+  connections
+  Module      Teensy
+  M0          3
+  M1          4
+  Rx          1 (MCU Tx line)
+  Tx          0 (MCU Rx line)
+  Aux         2
+  Vcc         3V3 (do NOT use the onboard regualtor if using the 30db unit as it draw too much power)
+  Gnd         Gnd
+
+*/
+
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+
+// connect to any of the Teensy Serial ports
+#define ESerial Serial1
+
+#define PIN_M0 3
+#define PIN_M1 4
+#define PIN_AX 2
+
+// same struct as the sender
+struct DATA {
+  unsigned long Count;
+  int Bits;
+  float Volts;
+  float Amps;
+};
+
+DATA MyData;
+unsigned long Last;
+
+// create the transceiver object, passing in the serial and pins
+EBYTE_E220 Transceiver(&ESerial, PIN_M0, PIN_M1, PIN_AX);
+
+// and the receiver that reads from the same serial port
+EBYTE_E220_Receiver Receiver(&ESerial);
+
+// called by the receiver each time a complete struct arrives
+void GotData(uint8_t type, uint8_t *data, uint8_t len, int16_t rssi, void *ctx) {
+
+  memcpy(&MyData, data, sizeof(MyData));
+
+  Serial.print("Count: ");
+  Serial.print(MyData.Count);
+  Serial.print(" Volts: ");
+  Serial.print(MyData.Volts);
+  Serial.print(" Signal strength: ");
+  Serial.print(rssi);
+  Serial.println(" db");
+
+  Last = millis();
+}
+
+void setup() {
+
+  Serial.begin(9600);
+
+  ESerial.begin(9600);
+
+  Serial.println("Starting Reader");
+
+  // this init will set the pinModes for you
+  Transceiver.init();
+
+  // have the module add the signal strength after each packet
+  Transceiver.setRSSISignalStrength(true);
+  Transceiver.saveParameters(EBYTE_WRITE_TEMPORARY);
+
+  // the sender writes plain structs, so each frame is one struct followed by the RSSI byte
+  Receiver.setFrameSize(sizeof(MyData));
+  Receiver.setRSSI(true);
+  Receiver.onFrame(GotData, NULL);
+
+  // from here on data received during setMode() etc. goes to the receiver
+  Transceiver.attachReceiver(&Receiver);
+
+  Transceiver.printParameters();
+}
+
+void loop() {
+
+  Receiver.service();
+
+  if ((millis() - Last) > 1000) {
+    Serial.println("Searching: ");
+    Last = millis();
+  }
+}
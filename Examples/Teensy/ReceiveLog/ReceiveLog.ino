@@ -0,0 +1,106 @@
+/*
+
+  This example logs every received frame to the SD card of a Teensy 3.6 / 4.1
+  in the binary format of EBYTE_E220_RxLog
+
+  each frame costs a few microseconds to log, whatever the air data rate, and the card
+  gets 512 byte writes from loop(). press the button (or send any character on Serial)
+  to close the log, then copy RXLOG.BIN to a computer and print it with extras/RxLogDecode
+
+  connections
+  Module      Teensy
+  M0          3
+  M1          4
+  Rx          1 (MCU Tx line)
+  Tx          0 (MCU Rx line)
+  Aux         2
+  Vcc         3V3 (do NOT use the onboard regualtor if using the 30db unit as it draw too much power)
+  Gnd         Gnd
+
+*/
+
+#include <SD.h>
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Receiver.h"
+#include "EBYTE_E220_RxLog.h"
+
+// connect to any of the Teensy Serial ports
+#define ESerial Serial1
+
+#define PIN_M0 3
+#define PIN_M1 4
+#define PIN_AX 2
+#define PIN_STOP 5
+
+File LogFile;
+
+EBYTE_E220 Transceiver(&ESerial, PIN_M0, PIN_M1, PIN_AX);
+EBYTE_E220_Receiver Receiver(&ESerial);
+
+EBYTE_PrintSink Sink(&LogFile);
+EBYTE_E220_RxLog Log(&Receiver, &Sink);
+
+bool Logging;
+unsigned long Last;
+
+void setup() {
+
+  Serial.begin(115200);
+
+  ESerial.begin(9600);
+
+  pinMode(PIN_STOP, INPUT_PULLUP);
+
+  if (!SD.begin(BUILTIN_SDCARD)) {
+    Serial.println("no SD card");
+    while (1);
+  }
+
+  SD.remove("RXLOG.BIN");
+  LogFile = SD.open("RXLOG.BIN", FILE_WRITE);
+
+  Transceiver.init();
+
+  // the module adds the signal strength after each packet, the log keeps it with the frame
+  Transceiver.setRSSISignalStrength(true);
+  Transceiver.saveParameters(EBYTE_WRITE_TEMPORARY);
+  Receiver.setRSSI(true);
+
+  Log.begin();
+
+  Transceiver.attachReceiver(&Receiver);
+
+  Logging = true;
+  Last = millis();
+}
+
+void loop() {
+
+  Receiver.service();
+
+  if (!Logging) {
+    return;
+  }
+
+  Log.service();
+
+  // a line a minute instead of a line a frame
+  if ((millis() - Last) > 60000) {
+    LogFile.flush();
+    Serial.print("frames ");
+    Serial.print(Log.getRecords());
+    Serial.print(" dropped ");
+    Serial.print(Log.getDropped());
+    Serial.print(" longest write ");
+    Serial.print(Log.getMaxWrite());
+    Serial.println(" us");
+    Last = millis();
+  }
+
+  if (digitalRead(PIN_STOP) == LOW || Serial.available()) {
+    Log.flush();
+    LogFile.close();
+    Logging = false;
+    Serial.println("log closed");
+  }
+}
@@ -0,0 +1,22 @@
+/*
+  Examples/Simulator/Benchmark as a host program, built with the Arduino.h in ../Provision
+
+  make			builds Benchmark
+  make run		builds it and prints the csv
+
+  the sketch reads cpu_us from clock() on the host and its loop() exits, so main() just runs
+  setup() and loop() like the Arduino core does
+*/
+
+#include "Arduino.h"
+
+#include "../../Examples/Simulator/Benchmark/Benchmark.ino"
+
+int main() {
+
+	setup();
+
+	for (;;) {
+		loop();
+	}
+}
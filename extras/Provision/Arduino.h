@@ -0,0 +1,138 @@
+/*
+  Just enough of the Arduino core to build the library on a Linux host, for the tools in this folder
+
+  millis() and micros() run from the monotonic clock, delay() sleeps, the pin functions do nothing
+  (the tools drive M0, M1 and AUX through an EBYTE_E220_Pins object) and Serial is stdout
+*/
+
+#ifndef EBYTE_HOST_ARDUINO_H
+#define EBYTE_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef ARDUINO
+#define ARDUINO 189
+#endif
+
+// sketches built with this file can tell they're on the host
+#define EBYTE_HOST
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *) (p))
+#define F(s) (s)
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#ifndef constrain
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class Print {
+
+public:
+
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *str) { return str ? write((const uint8_t *) str, strlen(str)) : 0; }
+	virtual void flush() {}
+
+	size_t print(const char *str) { return write(str); }
+	size_t print(char c) { return write((uint8_t) c); }
+	size_t print(unsigned char n, int base = DEC) { return print((unsigned long) n, base); }
+	size_t print(int n, int base = DEC) { return print((long) n, base); }
+	size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+	size_t print(double n, int digits = 2);
+
+	size_t println() { return write("\r\n"); }
+	size_t println(const char *str) { return print(str) + println(); }
+	size_t println(char c) { return print(c) + println(); }
+	size_t println(unsigned char n, int base = DEC) { return print(n, base) + println(); }
+	size_t println(int n, int base = DEC) { return print(n, base) + println(); }
+	size_t println(unsigned int n, int base = DEC) { return print(n, base) + println(); }
+	size_t println(long n, int base = DEC) { return print(n, base) + println(); }
+	size_t println(unsigned long n, int base = DEC) { return print(n, base) + println(); }
+	size_t println(double n, int digits = 2) { return print(n, digits) + println(); }
+
+};
+
+class Stream : public Print {
+
+public:
+
+	Stream() : _timeout(1000) {}
+
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+
+	void setTimeout(unsigned long timeout) { _timeout = timeout; }
+	size_t readBytes(uint8_t *buffer, size_t length);
+	size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *) buffer, length); }
+
+protected:
+
+	unsigned long _timeout;
+
+};
+
+// stdout, nothing is ever read from it
+class HostSerial : public Stream {
+
+public:
+
+	void begin(unsigned long) {}
+	operator bool() { return true; }
+
+	int available() { return 0; }
+	int read() { return -1; }
+	int peek() { return -1; }
+	size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+	using Print::write;
+	void flush() { fflush(stdout); }
+
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,144 @@
+/*
+  The host side of Arduino.h
+*/
+
+#include <time.h>
+#include <sched.h>
+
+#include "Arduino.h"
+
+HostSerial Serial;
+
+static uint64_t Now() {
+
+	static uint64_t start = 0;
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	uint64_t us = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+	if (start == 0) {
+		start = us;
+	}
+
+	return us - start;
+}
+
+unsigned long millis() {
+	return (unsigned long) (Now() / 1000);
+}
+
+unsigned long micros() {
+	return (unsigned long) Now();
+}
+
+void delay(unsigned long ms) {
+
+	struct timespec ts;
+
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (ms % 1000) * 1000000L;
+	nanosleep(&ts, NULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+
+	struct timespec ts;
+
+	ts.tv_sec = us / 1000000;
+	ts.tv_nsec = (us % 1000000) * 1000L;
+	nanosleep(&ts, NULL);
+}
+
+void yield() {
+	sched_yield();
+}
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t, uint8_t) {
+}
+
+int digitalRead(uint8_t) {
+	return HIGH;
+}
+
+long random(long howbig) {
+	return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+	return howbig > howsmall ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+
+	size_t n = 0;
+
+	while (size--) {
+		n += write(*buffer++);
+	}
+
+	return n;
+}
+
+size_t Print::print(long n, int base) {
+
+	if (n < 0 && base == DEC) {
+		return print('-') + print((unsigned long) -n, base);
+	}
+
+	return print((unsigned long) n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+
+	char buf[8 * sizeof(long) + 1];
+	char *str = &buf[sizeof(buf) - 1];
+
+	if (base < 2) {
+		base = DEC;
+	}
+
+	*str = '\0';
+	do {
+		char c = n % base;
+		n /= base;
+		*--str = c < 10 ? c + '0' : c + 'A' - 10;
+	} while (n);
+
+	return write(str);
+}
+
+size_t Print::print(double n, int digits) {
+
+	char buf[48];
+
+	snprintf(buf, sizeof(buf), "%.*f", digits, n);
+
+	return write(buf);
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length) {
+
+	size_t count = 0;
+	unsigned long start = millis();
+
+	while (count < length) {
+		int c = read();
+		if (c >= 0) {
+			buffer[count++] = (uint8_t) c;
+			start = millis();
+		}
+		else if ((millis() - start) >= _timeout) {
+			break;
+		}
+		else {
+			yield();
+		}
+	}
+
+	return count;
+}
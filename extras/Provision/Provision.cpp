@@ -0,0 +1,463 @@
+/*
+  Programs E220 modules from a manifest file, one module per serial port, and writes a report
+
+  build on the host with
+  g++ -O2 -DARDUINO=189 -I. -I../.. -o Provision Provision.cpp Host.cpp ../../EBYTE_E220.cpp \
+    ../../EBYTE_E220_Receiver.cpp ../../EBYTE_E220_Log.cpp ../../EBYTE_E220_Stats.cpp \
+    ../../EBYTE_E220_Manager.cpp ../../EBYTE_E220_Provision.cpp
+
+  Provision [-o report.txt] [-w] manifest.txt port [port ...]
+
+  -o report.txt		write the report to a file as well as stdout
+  -w				wait for Enter between batches, to swap the modules on the jig
+
+  each port is a serial device the module is on, at 9600 8N1 (the rate it takes commands at)
+  /dev/ttyUSB0					M0 on RTS, M1 on DTR and AUX on CTS of a USB serial adapter
+  /dev/ttyAMA0,m0,m1,aux		M0, M1 and AUX as GPIO value files, for example
+								/sys/class/gpio/gpio17/value (exported, with the direction set)
+
+  TTL adapters drive RTS and DTR low when they are asserted, so a line is asserted for LOW
+
+  the manifest format is in EBYTE_E220_Provision.h, units are programmed in order a batch at
+  a time, one unit per port. the exit status is 0 when every unit passed, 1 when any failed and
+  2 when the command line, the manifest or a port is wrong
+
+  ProvisionTest.cpp runs this tool against simulated modules on pseudo terminals
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+#include "Arduino.h"
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Manager.h"
+#include "EBYTE_E220_Provision.h"
+
+#define PORTS EBYTE_MANAGER_MODULES
+
+// a serial device as a Stream, reads never block
+
+class TtyStream : public Stream {
+
+public:
+
+	TtyStream() : _fd(-1), _pos(0), _len(0) {}
+
+	bool open(const char *path) {
+
+		struct termios t;
+
+		_fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+		if (_fd < 0) {
+			return false;
+		}
+
+		if (tcgetattr(_fd, &t) != 0) {
+			return false;
+		}
+
+		cfmakeraw(&t);
+		cfsetispeed(&t, B9600);
+		cfsetospeed(&t, B9600);
+		t.c_cflag |= CLOCAL | CREAD;
+		t.c_cflag &= ~(HUPCL | CSTOPB | CRTSCTS);
+
+		return tcsetattr(_fd, TCSANOW, &t) == 0;
+	}
+
+	int fd() {
+		return _fd;
+	}
+
+	int available() {
+		Fill();
+		return _len - _pos;
+	}
+
+	int read() {
+		Fill();
+		return _pos < _len ? _buf[_pos++] : -1;
+	}
+
+	int peek() {
+		Fill();
+		return _pos < _len ? _buf[_pos] : -1;
+	}
+
+	size_t write(uint8_t c) {
+		return write(&c, 1);
+	}
+
+	size_t write(const uint8_t *buffer, size_t size) {
+
+		size_t done = 0;
+
+		while (done < size) {
+			ssize_t n = ::write(_fd, buffer + done, size - done);
+			if (n > 0) {
+				done += n;
+			}
+			else if (n < 0 && errno == EAGAIN) {
+				struct pollfd p = {_fd, POLLOUT, 0};
+				::poll(&p, 1, 100);
+			}
+			else if (n < 0 && errno != EINTR) {
+				break;
+			}
+		}
+
+		return done;
+	}
+
+	using Print::write;
+
+	// like the Arduino cores, wait for the output to be sent
+	void flush() {
+		tcdrain(_fd);
+	}
+
+private:
+
+	void Fill() {
+
+		if (_pos < _len) {
+			return;
+		}
+
+		_pos = 0;
+		_len = 0;
+
+		ssize_t n = ::read(_fd, _buf, sizeof(_buf));
+		if (n > 0) {
+			_len = n;
+		}
+	}
+
+	int _fd;
+	uint8_t _buf[256];
+	int _pos;
+	int _len;
+
+};
+
+// M0 on RTS, M1 on DTR, AUX on CTS
+
+class ModemPins : public EBYTE_E220_Pins {
+
+public:
+
+	ModemPins(int fd) : _fd(fd) {}
+
+	bool begin() {
+		int status;
+		return ioctl(_fd, TIOCMGET, &status) == 0;
+	}
+
+	void setMode(uint8_t mode) {
+		Line(TIOCM_RTS, mode & 1);
+		Line(TIOCM_DTR, mode & 2);
+	}
+
+	bool getAux() {
+
+		int status;
+
+		if (ioctl(_fd, TIOCMGET, &status) != 0) {
+			return true;
+		}
+
+		return !(status & TIOCM_CTS);
+	}
+
+private:
+
+	void Line(int bit, bool high) {
+		ioctl(_fd, high ? TIOCMBIC : TIOCMBIS, &bit);
+	}
+
+	int _fd;
+
+};
+
+// M0, M1 and AUX as files holding 0 or 1, the way Linux exports GPIOs
+
+class GpioPins : public EBYTE_E220_Pins {
+
+public:
+
+	GpioPins() : _m0(-1), _m1(-1), _aux(-1) {}
+
+	bool begin(const char *m0, const char *m1, const char *aux) {
+		_m0 = ::open(m0, O_WRONLY);
+		_m1 = ::open(m1, O_WRONLY);
+		_aux = ::open(aux, O_RDONLY);
+		return _m0 >= 0 && _m1 >= 0 && _aux >= 0;
+	}
+
+	void setMode(uint8_t mode) {
+		Set(_m0, mode & 1);
+		Set(_m1, mode & 2);
+	}
+
+	bool getAux() {
+
+		char c;
+
+		if (pread(_aux, &c, 1, 0) != 1) {
+			return true;
+		}
+
+		return c != '0';
+	}
+
+private:
+
+	void Set(int fd, bool high) {
+		if (pwrite(fd, high ? "1\n" : "0\n", 2, 0) != 2) {
+			perror("gpio");
+		}
+	}
+
+	int _m0;
+	int _m1;
+	int _aux;
+
+};
+
+// the report goes to stdout and optionally a file
+
+class FilePrint : public Print {
+
+public:
+
+	FilePrint() : _f(NULL) {}
+
+	void begin(FILE *f) {
+		_f = f;
+	}
+
+	size_t write(uint8_t c) {
+		fputc(c, stdout);
+		if (_f) {
+			fputc(c, _f);
+		}
+		return 1;
+	}
+
+	using Print::write;
+
+private:
+
+	FILE *_f;
+
+};
+
+static bool ReadManifest(const char *path, EBYTE_Unit **units, unsigned *count) {
+
+	FILE *f = fopen(path, "r");
+	char line[256];
+	unsigned n = 0;
+	unsigned size = 0;
+	unsigned number = 0;
+	bool ok = true;
+
+	if (f == NULL) {
+		perror(path);
+		return false;
+	}
+
+	*units = NULL;
+
+	while (fgets(line, sizeof(line), f)) {
+
+		EBYTE_Unit unit;
+		const char *p = line;
+
+		number++;
+
+		if (EBYTE_E220_Provision::parse(line, &unit, number)) {
+			if (n == size) {
+				size = size ? size * 2 : 16;
+				*units = (EBYTE_Unit *) realloc(*units, size * sizeof(EBYTE_Unit));
+			}
+			(*units)[n++] = unit;
+			continue;
+		}
+
+		// blank lines and comments are fine, anything else is a mistake in the manifest
+		while (*p == ' ' || *p == '\t') {
+			p++;
+		}
+		if (*p != '#' && *p != '\0' && *p != '\r' && *p != '\n') {
+			fprintf(stderr, "%s:%u: can't parse %s", path, number, line);
+			ok = false;
+		}
+	}
+
+	fclose(f);
+
+	*count = n;
+
+	return ok;
+}
+
+static void Usage() {
+	fprintf(stderr, "usage: Provision [-o report.txt] [-w] manifest.txt port[,m0,m1,aux] [port ...]\n");
+}
+
+int main(int argc, char **argv) {
+
+	const char *reportPath = NULL;
+	const char *manifest = NULL;
+	const char *ports[PORTS];
+	unsigned portCount = 0;
+	bool wait = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			reportPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-w") == 0) {
+			wait = true;
+		}
+		else if (argv[i][0] == '-') {
+			Usage();
+			return 2;
+		}
+		else if (manifest == NULL) {
+			manifest = argv[i];
+		}
+		else if (portCount < PORTS) {
+			ports[portCount++] = argv[i];
+		}
+		else {
+			fprintf(stderr, "at most %d ports\n", PORTS);
+			return 2;
+		}
+	}
+
+	if (manifest == NULL || portCount == 0) {
+		Usage();
+		return 2;
+	}
+
+	EBYTE_Unit *units;
+	unsigned unitCount;
+
+	if (!ReadManifest(manifest, &units, &unitCount)) {
+		return 2;
+	}
+
+	FILE *reportFile = NULL;
+
+	if (reportPath) {
+		reportFile = fopen(reportPath, "w");
+		if (reportFile == NULL) {
+			perror(reportPath);
+			return 2;
+		}
+	}
+
+	TtyStream streams[PORTS];
+	EBYTE_E220_Pins *pins[PORTS];
+	EBYTE_E220 *radios[PORTS];
+	EBYTE_E220_Manager manager;
+	EBYTE_E220_Provision provision(&manager);
+	FilePrint report;
+
+	for (unsigned i = 0; i < portCount; i++) {
+
+		char spec[256];
+
+		strncpy(spec, ports[i], sizeof(spec) - 1);
+		spec[sizeof(spec) - 1] = '\0';
+
+		char *path = strtok(spec, ",");
+		char *m0 = strtok(NULL, ",");
+		char *m1 = strtok(NULL, ",");
+		char *aux = strtok(NULL, ",");
+
+		if (path == NULL || !streams[i].open(path)) {
+			perror(ports[i]);
+			return 2;
+		}
+
+		if (m0) {
+			GpioPins *gpio = new GpioPins();
+			if (m1 == NULL || aux == NULL || !gpio->begin(m0, m1, aux)) {
+				fprintf(stderr, "%s: need three readable and writable GPIO files\n", ports[i]);
+				return 2;
+			}
+			pins[i] = gpio;
+		}
+		else {
+			ModemPins *modem = new ModemPins(streams[i].fd());
+			if (!modem->begin()) {
+				fprintf(stderr, "%s: no modem lines, give M0, M1 and AUX as GPIO files\n", path);
+				return 2;
+			}
+			pins[i] = modem;
+		}
+
+		radios[i] = new EBYTE_E220(&streams[i]);
+		radios[i]->setPins(pins[i]);
+		manager.add(radios[i]);
+	}
+
+	report.begin(reportFile);
+
+	unsigned passed = 0;
+	unsigned batch = 0;
+	unsigned long start = millis();
+
+	for (unsigned first = 0; first < unitCount; first += portCount) {
+
+		uint8_t n = min(portCount, unitCount - first);
+
+		if (wait && first) {
+			char line[16];
+			fprintf(stderr, "put the next %u modules on the jig and press Enter\n", n);
+			if (fgets(line, sizeof(line), stdin) == NULL) {
+				break;
+			}
+		}
+
+		if (!provision.begin(units + first, n)) {
+			fprintf(stderr, "couldn't start batch %u\n", batch);
+			return 2;
+		}
+
+		while (!provision.done()) {
+			provision.service();
+			usleep(200);
+		}
+
+		report.print("batch ");
+		report.println(batch++);
+		provision.printReport(&report);
+
+		passed += provision.getPassed();
+	}
+
+	report.print(passed);
+	report.print(" of ");
+	report.print(unitCount);
+	report.print(" units passed in ");
+	report.print(millis() - start);
+	report.println(" ms");
+
+	if (reportFile) {
+		fclose(reportFile);
+	}
+
+	free(units);
+
+	return passed == unitCount ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+/*
+  Runs the Provision tool against simulated modules on pseudo terminals
+
+  build Provision (see Provision.cpp), then
+  g++ -O2 -DARDUINO=189 -I. -I../.. -o ProvisionTest ProvisionTest.cpp Host.cpp ../../EBYTE_E220.cpp \
+    ../../EBYTE_E220_Receiver.cpp ../../EBYTE_E220_Log.cpp ../../EBYTE_E220_Stats.cpp ../../EBYTE_E220_Sim.cpp -lutil
+
+  ProvisionTest ./Provision
+
+  each EBYTE_E220_Sim sits on the master side of a pty and the tool gets the slave side. M0, M1
+  and AUX are files in a temporary folder, the tool writes M0 and M1 and reads AUX as it would
+  GPIO value files, and this program passes them to and from the simulators. a manifest of 7 units
+  goes through 4 ports in two batches, then every unit must pass, the report must have a line
+  for each unit starting with its manifest line number and the simulators must hold the last
+  batch's settings. exit status 0 on success
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pty.h>
+#include <termios.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "Arduino.h"
+#include "EBYTE_E220.h"
+#include "EBYTE_E220_Sim.h"
+
+#define MODULES 4
+
+const char *Manifest =
+	"# address, channel, key, air data rate (bps), transmit power\n"
+	"0x0101, 10, 0xBEEF, 9600, 0\n"
+	"0x0102, 20, 0xBEEF, 9600, 0\n"
+	"\n"
+	"0x0201, 10, 0x1234, 2400, 1\n"
+	"0x0202, 10, 0x1234, 2400, 1\n"
+	"0x0203, 20, 0x1234, 2400, 1\n"
+	"0x0204, 20, 0x1234, 2400, 1\n"
+	"0x0205, 21, 0x1234, 4800, 2\n";
+
+#define UNITS 7
+
+// where each unit is in the manifest, the report starts its line with it
+const int Lines[UNITS] = {2, 3, 5, 6, 7, 8, 9};
+
+struct Module {
+	EBYTE_E220_Sim Sim;
+	int Master;
+	int Slave;
+	char Tty[64];
+	char M0[96];
+	char M1[96];
+	char Aux[96];
+	uint8_t Mode;
+	int AuxLevel;
+};
+
+Module Modules[MODULES];
+char Dir[] = "/tmp/e220provXXXXXX";
+
+static void WriteFile(const char *path, const char *text) {
+
+	FILE *f = fopen(path, "w");
+
+	if (f == NULL) {
+		perror(path);
+		exit(2);
+	}
+
+	fputs(text, f);
+	fclose(f);
+}
+
+static int ReadLevel(const char *path) {
+
+	char c = '0';
+	int fd = open(path, O_RDONLY);
+
+	if (fd >= 0) {
+		if (read(fd, &c, 1) != 1) {
+			c = '0';
+		}
+		close(fd);
+	}
+
+	return c != '0';
+}
+
+// move the pins and the bytes between the tool and the simulators
+
+static void Bridge(Module *m) {
+
+	uint8_t buf[256];
+	uint8_t mode = ReadLevel(m->M0) | (ReadLevel(m->M1) << 1);
+
+	if (mode != m->Mode) {
+		m->Mode = mode;
+		m->Sim.setMode(mode);
+	}
+
+	ssize_t n = read(m->Master, buf, sizeof(buf));
+	if (n > 0) {
+		m->Sim.write(buf, n);
+	}
+
+	n = 0;
+	while (n < (ssize_t) sizeof(buf) && m->Sim.available()) {
+		buf[n++] = m->Sim.read();
+	}
+	if (n > 0 && write(m->Master, buf, n) != n) {
+		perror("pty");
+	}
+
+	int aux = m->Sim.getAux() ? 1 : 0;
+	if (aux != m->AuxLevel) {
+		m->AuxLevel = aux;
+		WriteFile(m->Aux, aux ? "1\n" : "0\n");
+	}
+}
+
+int main(int argc, char **argv) {
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: ProvisionTest path/to/Provision\n");
+		return 2;
+	}
+
+	if (mkdtemp(Dir) == NULL) {
+		perror(Dir);
+		return 2;
+	}
+
+	char manifest[64];
+	char report[64];
+
+	snprintf(manifest, sizeof(manifest), "%s/manifest.txt", Dir);
+	snprintf(report, sizeof(report), "%s/report.txt", Dir);
+	WriteFile(manifest, Manifest);
+
+	const char *args[4 + MODULES + 1];
+	char specs[MODULES][320];
+	int argn = 0;
+
+	args[argn++] = argv[1];
+	args[argn++] = "-o";
+	args[argn++] = report;
+	args[argn++] = manifest;
+
+	for (int i = 0; i < MODULES; i++) {
+
+		Module *m = &Modules[i];
+		struct termios t;
+
+		if (openpty(&m->Master, &m->Slave, m->Tty, NULL, NULL) != 0) {
+			perror("openpty");
+			return 2;
+		}
+
+		// the slave end stays open here so the master never sees a hangup
+		tcgetattr(m->Slave, &t);
+		cfmakeraw(&t);
+		tcsetattr(m->Slave, TCSANOW, &t);
+		fcntl(m->Master, F_SETFL, fcntl(m->Master, F_GETFL) | O_NONBLOCK);
+
+		snprintf(m->M0, sizeof(m->M0), "%s/m0_%d", Dir, i);
+		snprintf(m->M1, sizeof(m->M1), "%s/m1_%d", Dir, i);
+		snprintf(m->Aux, sizeof(m->Aux), "%s/aux_%d", Dir, i);
+		WriteFile(m->M0, "0\n");
+		WriteFile(m->M1, "0\n");
+		WriteFile(m->Aux, "1\n");
+		m->Mode = EBYTE_MODE_NORMAL;
+		m->AuxLevel = 1;
+		m->Sim.setMode(EBYTE_MODE_NORMAL);
+
+		snprintf(specs[i], sizeof(specs[i]), "%s,%s,%s,%s", m->Tty, m->M0, m->M1, m->Aux);
+		args[argn++] = specs[i];
+	}
+
+	args[argn] = NULL;
+
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		execv(args[0], (char * const *) args);
+		perror(args[0]);
+		_exit(127);
+	}
+
+	int status = 0;
+	unsigned long start = millis();
+
+	for (;;) {
+
+		for (int i = 0; i < MODULES; i++) {
+			Bridge(&Modules[i]);
+		}
+
+		if (waitpid(pid, &status, WNOHANG) == pid) {
+			break;
+		}
+
+		if ((millis() - start) > 60000) {
+			fprintf(stderr, "Provision didn't finish\n");
+			kill(pid, SIGKILL);
+			return 1;
+		}
+
+		usleep(100);
+	}
+
+	int failures = 0;
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "Provision exit status %d\n", WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+		failures++;
+	}
+
+	// one OK line per unit in the report, in manifest order
+	FILE *f = fopen(report, "r");
+	char line[256];
+	int ok = 0;
+
+	if (f) {
+		while (fgets(line, sizeof(line), f)) {
+			if (strstr(line, " OK ")) {
+				if (ok < UNITS && atoi(line) != Lines[ok]) {
+					fprintf(stderr, "unit %d is on report line %s", ok, line);
+					failures++;
+				}
+				ok++;
+			}
+		}
+		fclose(f);
+	}
+
+	if (ok != UNITS) {
+		fprintf(stderr, "report has %d of %d units OK\n", ok, UNITS);
+		failures++;
+	}
+
+	// the second batch put the last 3 units on modules 0 to 2, module 3 kept the 4th unit
+	const uint16_t address[MODULES] = {0x0203, 0x0204, 0x0205, 0x0202};
+	const uint8_t channel[MODULES] = {20, 20, 21, 10};
+
+	for (int i = 0; i < MODULES; i++) {
+		EBYTE_E220_Sim *s = &Modules[i].Sim;
+		uint16_t a = (s->getRegister(0) << 8) | s->getRegister(1);
+		if (a != address[i] || s->getRegister(4) != channel[i]) {
+			fprintf(stderr, "module %d has address 0x%04X channel %u\n", i, a, s->getRegister(4));
+			failures++;
+		}
+	}
+
+	printf("%d of %d units OK in the report, %s\n", ok, UNITS, failures ? "FAILED" : "passed");
+
+	return failures ? 1 : 0;
+}
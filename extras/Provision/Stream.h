@@ -0,0 +1,2 @@
+// Stream lives in Arduino.h on the host
+#include "Arduino.h"
@@ -0,0 +1,136 @@
+/*
+  Prints a receive log written by EBYTE_E220_RxLog, one line per frame
+
+  build on the host with
+  g++ -O2 -o RxLogDecode RxLogDecode.cpp
+
+  RxLogDecode log.bin			time_ms rssi type len data (hex)
+  RxLogDecode -c log.bin		the same as CSV
+  RxLogDecode -s log.bin		only totals
+
+  the file format is described in EBYTE_E220_RxLog.h
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HEADER 8
+#define RECORD 7
+
+static uint16_t Get16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t Get32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+int main(int argc, char **argv) {
+
+	bool csv = false;
+	bool summary = false;
+	const char *path = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-c") == 0) {
+			csv = true;
+		}
+		else if (strcmp(argv[i], "-s") == 0) {
+			summary = true;
+		}
+		else {
+			path = argv[i];
+		}
+	}
+
+	if (path == NULL) {
+		fprintf(stderr, "usage: RxLogDecode [-c] [-s] log.bin\n");
+		return 2;
+	}
+
+	FILE *f = fopen(path, "rb");
+
+	if (f == NULL) {
+		perror(path);
+		return 1;
+	}
+
+	uint8_t block[256 * 255];
+	unsigned long blocks = 0, records = 0, bad = 0, gaps = 0, bytes = 0;
+	uint16_t expect = 0;
+	uint32_t first = 0, last = 0;
+
+	if (csv && !summary) {
+		printf("time_ms,rssi,type,len,data\n");
+	}
+
+	for (;;) {
+
+		// the header says how big the block is
+		if (fread(block, 1, HEADER, f) != HEADER) {
+			break;
+		}
+
+		if (block[0] != 'E' || block[1] != 'L' || block[2] != 1 || block[3] == 0) {
+			// zero filled tail of a file that wasn't trimmed, or not a log
+			if (block[0] != 0) {
+				bad++;
+			}
+			break;
+		}
+
+		size_t size = block[3] * 256;
+		uint16_t seq = Get16(block + 4);
+		uint16_t used = Get16(block + 6);
+
+		if (fread(block + HEADER, 1, size - HEADER, f) != size - HEADER || used > size) {
+			bad++;
+			break;
+		}
+
+		if (blocks && seq != expect) {
+			gaps++;
+		}
+		expect = seq + 1;
+		blocks++;
+
+		for (size_t pos = HEADER; pos + RECORD <= used; ) {
+
+			const uint8_t *r = block + pos;
+			uint32_t time = Get32(r);
+			int rssi = (int8_t) r[4];
+			uint8_t type = r[5];
+			uint8_t len = r[6];
+
+			if (pos + RECORD + len > used) {
+				bad++;
+				break;
+			}
+
+			if (records == 0) {
+				first = time;
+			}
+			last = time;
+			records++;
+			bytes += len;
+
+			if (!summary) {
+				printf(csv ? "%lu,%d,%u,%u," : "%10lu %4d %3u %3u ", (unsigned long) time, rssi, type, len);
+				for (uint8_t i = 0; i < len; i++) {
+					printf("%02X", r[RECORD + i]);
+				}
+				printf("\n");
+			}
+
+			pos += RECORD + len;
+		}
+	}
+
+	fclose(f);
+
+	fprintf(summary ? stdout : stderr, "%lu blocks, %lu frames, %lu data bytes over %lu ms, %lu sequence gaps, %lu bad\n",
+		blocks, records, bytes, (unsigned long) (last - first), gaps, bad);
+
+	return bad ? 1 : 0;
+}